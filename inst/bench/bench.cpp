@@ -0,0 +1,221 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+#include "VCFreader.h"
+#include "VCFstringToGeno.h"
+#include "tokenPosition.h"
+#include "tokenAtPosition.h"
+#include "stringStreamLite.h"
+#include "constStringStreamLite.h"
+#include "VCFlineGenotypes.h"
+#include "syntheticVCF.h"
+
+// Benchmarks, hors du package (cf Makefile) : génération de VCF synthétiques
+// et mesure du débit des fonctions de parsing (cf bench.R pour la lecture
+// complète par readVCFgenotypes)
+//   bench synthetic file [samples variants format missing phased seed]
+//     écrit un VCF synthétique (cf syntheticVCF.h), compressé si file finit
+//     par .gz ; format : les champs séparés par des virgules, ex. GT,DS ;
+//     affiche sa taille non compressée
+//   bench parsing file [reps maxLines]
+
+// le meilleur temps (secondes) de reps exécutions de f
+// f renvoie une valeur quelconque, accumulée pour que le compilateur
+// ne puisse pas supprimer le calcul
+template<typename F>
+static double bestTime(int reps, F f, size_t & check) {
+  double best = -1;
+  for(int r = 0; r < reps; r++) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    check += f();
+    double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if(best < 0 || t < best) best = t;
+  }
+  return best;
+}
+
+// Débit des briques du parsing, sur les lignes de données de filename
+// (lues en mémoire au préalable, la lecture du fichier n'est pas comptée) :
+//   VCFstringToGeno : sur les champs GT de chaque sample
+//   tokenPosition : recherche de GT dans FORMAT (version std::string et version [b, e))
+//   tokenAtPosition : extraction de GT dans le champ de chaque sample (idem)
+//   stringStreamLite / constStringStreamLite : découpage des lignes aux tabulations
+//   VCFlineGenotypes : décodage complet des lignes
+// Affiche un tableau : octets et éléments traités, meilleur temps sur
+// reps répétitions, MB/s et éléments/s
+static void benchParsing(const std::string & filename, int reps, int maxLines) {
+  VCFreader in(filename, 1);
+  std::vector<std::string> lines;
+  std::string line;
+  while((maxLines < 0 || lines.size() < (size_t) maxLines) && in.getline(line))
+    lines.push_back(line);
+  if(lines.empty())
+    throw std::runtime_error("No variant in " + filename + "\n");
+  size_t nsamples = in.samples.size();
+
+  // FORMAT, champs des samples et GT, repérés une fois pour toutes
+  std::vector<std::string> formats;
+  std::vector<charSpan> fields, gts;
+  std::vector<int> gtPos;
+  size_t lineBytes = 0, formatBytes = 0, fieldBytes = 0, gtBytes = 0;
+  for(const std::string & l : lines) {
+    lineBytes += l.size() + 1;
+    constStringStreamLite li(l.data(), l.data() + l.size(), 9);
+    charSpan tok;
+    for(int k = 0; k < 9 && (li >> tok); k++) {}
+    formats.push_back(tok.str());
+    formatBytes += tok.size();
+    int p = tokenPosition(tok.begin, tok.end, "GT");
+    gtPos.push_back(p);
+    while(li >> tok) {
+      fields.push_back(tok);
+      fieldBytes += tok.size();
+      if(p >= 0) {
+        gts.push_back(tokenAtPosition(tok.begin, tok.end, p));
+        gtBytes += gts.back().size();
+      }
+    }
+  }
+  std::vector<std::string> fieldStrings;
+  for(const charSpan & f : fields) fieldStrings.push_back(f.str());
+  std::vector<std::string> copies(lines); // stringStreamLite modifie les chaînes
+
+  std::vector<std::string> test;
+  std::vector<double> bytes, items, seconds;
+  size_t check = 0;
+  auto add = [&](const char * name, double by, double it, double t) {
+    test.push_back(name);
+    bytes.push_back(by);
+    items.push_back(it);
+    seconds.push_back(t);
+  };
+
+  add("VCFstringToGeno", gtBytes, gts.size(), bestTime(reps, [&]() {
+    size_t s = 0;
+    for(const charSpan & g : gts) s += VCFstringToGeno<int>(g.begin, g.size());
+    return s;
+  }, check));
+
+  add("tokenPosition (std::string)", formatBytes, formats.size(), bestTime(reps, [&]() {
+    size_t s = 0;
+    for(const std::string & f : formats) s += tokenPosition<int>(f, "GT");
+    return s;
+  }, check));
+
+  add("tokenPosition (span)", formatBytes, formats.size(), bestTime(reps, [&]() {
+    size_t s = 0;
+    for(const std::string & f : formats) s += tokenPosition(f.data(), f.data() + f.size(), "GT");
+    return s;
+  }, check));
+
+  add("tokenAtPosition (std::string)", fieldBytes, fields.size(), bestTime(reps, [&]() {
+    size_t s = 0, k = 0;
+    for(size_t i = 0; i < lines.size(); i++) {
+      if(gtPos[i] < 0) {
+        k += nsamples;
+        continue;
+      }
+      for(size_t j = 0; j < nsamples && k < fieldStrings.size(); j++, k++)
+        s += tokenAtPosition<std::string>(fieldStrings[k], gtPos[i]).size();
+    }
+    return s;
+  }, check));
+
+  add("tokenAtPosition (span)", fieldBytes, fields.size(), bestTime(reps, [&]() {
+    size_t s = 0, k = 0;
+    for(size_t i = 0; i < lines.size(); i++) {
+      if(gtPos[i] < 0) {
+        k += nsamples;
+        continue;
+      }
+      for(size_t j = 0; j < nsamples && k < fields.size(); j++, k++)
+        s += tokenAtPosition(fields[k].begin, fields[k].end, gtPos[i]).size();
+    }
+    return s;
+  }, check));
+
+  add("stringStreamLite", lineBytes, lines.size(), bestTime(reps, [&]() {
+    size_t s = 0;
+    std::string tok;
+    for(std::string & l : copies) {
+      stringStreamLite li(l, '\t');
+      while(li >> tok) s += tok.size();
+    }
+    return s;
+  }, check));
+
+  add("constStringStreamLite", lineBytes, lines.size(), bestTime(reps, [&]() {
+    size_t s = 0;
+    charSpan tok;
+    for(const std::string & l : lines) {
+      constStringStreamLite li(l.data(), l.data() + l.size(), 9);
+      while(li >> tok) s += tok.size();
+    }
+    return s;
+  }, check));
+
+  add("VCFlineGenotypes", lineBytes, lines.size(), bestTime(reps, [&]() {
+    size_t s = 0;
+    std::vector<int> dest(nsamples);
+    VCFsnpInfo<charSpan, charSpan> snp;
+    formatCache fc;
+    for(const std::string & l : lines) {
+      VCFlineGenotypes(l.data(), l.data() + l.size(), snp, dest.data(), 1, nsamples, fc);
+      s += dest[0];
+    }
+    return s;
+  }, check));
+
+  printf("%-30s %12s %12s %10s %10s %12s\n", "test", "bytes", "items", "seconds", "MB.s", "items.s");
+  for(size_t k = 0; k < test.size(); k++)
+    printf("%-30s %12.0f %12.0f %10.4g %10.4g %12.4g\n", test[k].c_str(), bytes[k], items[k], seconds[k],
+           bytes[k] / seconds[k] / 1e6, items[k] / seconds[k]);
+  // pour que le compilateur ne puisse pas supprimer les calculs
+  fprintf(stderr, "check %zu\n", check);
+}
+
+static std::vector<std::string> splitCommas(const std::string & s) {
+  std::vector<std::string> r;
+  size_t b = 0;
+  for(size_t c; (c = s.find(',', b)) != std::string::npos; b = c + 1) r.push_back(s.substr(b, c - b));
+  r.push_back(s.substr(b));
+  return r;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: bench synthetic file [samples variants format missing phased seed]\n"
+                  "       bench parsing file [reps maxLines]\n");
+  exit(2);
+}
+
+int main(int argc, char ** argv) {
+  if(argc < 3) usage();
+  std::string cmd = argv[1], filename = argv[2];
+  try {
+    if(cmd == "synthetic") {
+      syntheticVCFparams P;
+      if(argc > 3) P.nsamples = atol(argv[3]);
+      if(argc > 4) P.nvariants = atol(argv[4]);
+      if(argc > 5) P.format = splitCommas(argv[5]);
+      if(argc > 6) P.missing = atof(argv[6]);
+      if(argc > 7) P.phased = atoi(argv[7]) != 0;
+      if(argc > 8) P.seed = strtoull(argv[8], NULL, 10);
+      if(P.nsamples < 1)
+        throw std::runtime_error("samples should be positive\n");
+      P.compress = filename.size() > 3 && filename.compare(filename.size() - 3, 3, ".gz") == 0;
+      printf("%zu\n", writeSyntheticVCF(filename, P));
+    } else if(cmd == "parsing") {
+      benchParsing(filename, argc > 3 ? atoi(argv[3]) : 3, argc > 4 ? atoi(argv[4]) : 100000);
+    } else {
+      usage();
+    }
+  } catch(std::exception & e) {
+    fprintf(stderr, "%s", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,178 @@
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <zlib.h>
+
+#ifndef _syntheticVCF_
+#define _syntheticVCF_
+
+// Génération de VCF synthétiques, pour les benchmarks
+// Un seul contig ("1"), des SNPs bialléliques ; pour chaque SNP une
+// fréquence allélique tirée uniformément dans [0.01, 0.5], puis les
+// génotypes de chaque sample sous Hardy-Weinberg.
+// Les champs FORMAT possibles : GT, DS (dosage), GP (probabilités),
+// DP et GQ (entiers), dans l'ordre donné, sauf GT qui est toujours
+// placé en premier (cf la norme VCF)
+
+struct syntheticVCFparams {
+  size_t nsamples = 100;
+  size_t nvariants = 10000;
+  std::vector<std::string> format = std::vector<std::string>(1, "GT");
+  double missing = 0.0; // proportion de génotypes manquants
+  bool phased = false;
+  bool compress = false; // gzip
+  uint64_t seed = 1;
+};
+
+// xorshift64*, reproductible d'une plateforme à l'autre
+class syntheticRNG {
+  private:
+  uint64_t s;
+
+  public:
+  explicit syntheticRNG(uint64_t seed) : s(seed ? seed : 88172645463325252ULL) {}
+
+  uint64_t next() {
+    s ^= s >> 12;
+    s ^= s << 25;
+    s ^= s >> 27;
+    return s * 2685821657736338717ULL;
+  }
+
+  // uniforme dans [0, 1)
+  double unif() {
+    return (next() >> 11) * (1.0 / 9007199254740992.0);
+  }
+};
+
+// sortie texte ou gzip
+class syntheticOutput {
+  private:
+  FILE * f;
+  gzFile gz;
+
+  public:
+  syntheticOutput(const std::string & filename, bool compress) : f(NULL), gz(NULL) {
+    if(compress)
+      gz = gzopen(filename.c_str(), "wb6");
+    else
+      f = fopen(filename.c_str(), "wb");
+    if(f == NULL && gz == NULL)
+      throw std::runtime_error("Couldn't create file " + filename + "\n");
+  }
+
+  ~syntheticOutput() {
+    if(f != NULL) fclose(f);
+    if(gz != NULL) gzclose(gz);
+  }
+
+  syntheticOutput(const syntheticOutput &) = delete;
+  syntheticOutput & operator=(const syntheticOutput &) = delete;
+
+  void write(const std::string & s) {
+    if(s.empty()) return;
+    bool ok = (f != NULL) ? fwrite(s.data(), 1, s.size(), f) == s.size()
+                          : gzwrite(gz, s.data(), (unsigned) s.size()) == (int) s.size();
+    if(!ok)
+      throw std::runtime_error("Couldn't write synthetic VCF\n");
+  }
+};
+
+inline void appendFixed(std::string & s, double x, int digits) {
+  char b[32];
+  int n = snprintf(b, sizeof(b), "%.*f", digits, x);
+  s.append(b, n);
+}
+
+// écrit le VCF ; renvoie sa taille (non compressée) en octets
+inline size_t writeSyntheticVCF(const std::string & filename, const syntheticVCFparams & P0) {
+  static const char bases[4] = {'A', 'C', 'G', 'T'};
+  syntheticVCFparams P = P0;
+  for(const std::string & f : P.format)
+    if(f != "GT" && f != "DS" && f != "GP" && f != "DP" && f != "GQ")
+      throw std::runtime_error("Unknown FORMAT field " + f + "\n");
+  if(P.format.empty())
+    throw std::runtime_error("Empty FORMAT\n");
+  std::stable_partition(P.format.begin(), P.format.end(), [](const std::string & f) { return f == "GT"; });
+
+  syntheticOutput out(filename, P.compress);
+  syntheticRNG rng(P.seed);
+  size_t total = 0;
+  std::string s;
+  s += "##fileformat=VCFv4.2\n";
+  s += "##source=readVCF::writeSyntheticVCF\n";
+  s += "##contig=<ID=1,length=249250621>\n";
+  s += "##INFO=<ID=AF,Number=A,Type=Float,Description=\"Simulated allele frequency\">\n";
+  for(const std::string & f : P.format) {
+    if(f == "GT") s += "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n";
+    if(f == "DS") s += "##FORMAT=<ID=DS,Number=A,Type=Float,Description=\"Alternate allele dosage\">\n";
+    if(f == "GP") s += "##FORMAT=<ID=GP,Number=G,Type=Float,Description=\"Genotype probabilities\">\n";
+    if(f == "DP") s += "##FORMAT=<ID=DP,Number=1,Type=Integer,Description=\"Read depth\">\n";
+    if(f == "GQ") s += "##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Genotype quality\">\n";
+  }
+  s += "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+  for(size_t j = 0; j < P.nsamples; j++) s += "\tS" + std::to_string(j + 1);
+  s += '\n';
+
+  std::string format = P.format[0];
+  for(size_t k = 1; k < P.format.size(); k++) format += ":" + P.format[k];
+
+  uint64_t pos = 10000;
+  for(size_t i = 0; i < P.nvariants; i++) {
+    pos += 1 + rng.next() % 200;
+    int r = rng.next() % 4, a = (r + 1 + rng.next() % 3) % 4;
+    double af = 0.01 + 0.49 * rng.unif();
+    s += "1\t" + std::to_string(pos) + "\trs" + std::to_string(i + 1) + '\t' + bases[r] + '\t' + bases[a] + "\t.\tPASS\tAF=";
+    appendFixed(s, af, 4);
+    s += '\t' + format;
+    for(size_t j = 0; j < P.nsamples; j++) {
+      s += '\t';
+      bool miss = P.missing > 0 && rng.unif() < P.missing;
+      int a1 = rng.unif() < af, a2 = rng.unif() < af;
+      double ds = a1 + a2;
+      for(size_t k = 0; k < P.format.size(); k++) {
+        if(k > 0) s += ':';
+        const std::string & f = P.format[k];
+        if(f == "GT") {
+          if(miss) {
+            s += P.phased ? ".|." : "./.";
+          } else {
+            s += (char) ('0' + a1);
+            s += P.phased ? '|' : '/';
+            s += (char) ('0' + a2);
+          }
+        } else if(miss) {
+          s += '.';
+        } else if(f == "DS") {
+          appendFixed(s, std::min(2.0, std::max(0.0, ds + 0.1 * (rng.unif() - 0.5))), 3);
+        } else if(f == "GP") {
+          double e = 0.05 * rng.unif(), gp[3] = {e / 2, e / 2, e / 2};
+          gp[(int) ds] = 1 - e;
+          for(int g = 0; g < 3; g++) {
+            if(g > 0) s += ',';
+            appendFixed(s, gp[g], 3);
+          }
+        } else if(f == "DP") {
+          s += std::to_string(5 + rng.next() % 40);
+        } else if(f == "GQ") {
+          s += std::to_string(rng.next() % 100);
+        }
+      }
+    }
+    s += '\n';
+    if(s.size() > (1 << 22)) {
+      out.write(s);
+      total += s.size();
+      s.clear();
+    }
+  }
+  out.write(s);
+  total += s.size();
+  return total;
+}
+
+#endif
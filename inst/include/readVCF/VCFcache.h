@@ -0,0 +1,406 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+#include "mmapFile.h"
+#include "bgzf.h"
+#include "constStringStreamLite.h"
+#include "variantTable.h"
+#include "packedGenotypes.h"
+
+#ifndef _VCFcache_
+#define _VCFcache_
+
+// Cache binaire d'un VCF lu en entier, à côté du fichier (filename.rvc) :
+//   en-tête : "readVCF" + version, taille et date de modification du VCF,
+//      nombre de SNPs et de samples, de quoi reprendre la lecture (cf VCFstamp)
+//   les noms des samples, les contigs, CHROM (codes), POS, ID, REF, ALT
+//   les génotypes sur 2 bits (cf packedGenotypes), une ligne par SNP
+// Les chaînes sont stockées en arena (nombre, offsets, octets) ; chaque
+// section est alignée sur 8 octets. Le cache est relu par projection en
+// mémoire, sans copie : l'accès à un intervalle de SNPs est direct.
+// Le format est celui de la machine (pas d'échange d'octets)
+// Quand des variants ont seulement été ajoutés à la fin du VCF, seules les
+// nouvelles lignes sont lues, et ajoutées au cache (cf readVCFgenotypes)
+
+static const char VCFcacheMagic[8] = {'r', 'e', 'a', 'd', 'V', 'C', 'F', 2};
+
+// taille et date de modification d'un fichier ; false s'il n'existe pas
+inline bool fileStamp(const std::string & filename, uint64_t & size, int64_t & mtime) {
+  struct stat st;
+  if(stat(filename.c_str(), &st) != 0) return false;
+  size = st.st_size;
+  mtime = st.st_mtime;
+  return true;
+}
+
+inline std::string VCFcacheFile(const std::string & filename) {
+  return filename + ".rvc";
+}
+
+// FNV-1a 64 bits
+inline uint64_t fnv1a(const void * p, size_t n, uint64_t h = 14695981039346656037ULL) {
+  const unsigned char * c = (const unsigned char *) p;
+  for(size_t i = 0; i < n; i++) h = (h ^ c[i]) * 1099511628211ULL;
+  return h;
+}
+
+// empreinte de l'en-tête : les lignes "##" et les noms des samples
+inline uint64_t headerFingerprint(const std::vector<std::string> & header, const std::vector<std::string> & samples) {
+  uint64_t h = fnv1a(NULL, 0);
+  for(const std::string & l : header) h = fnv1a(l.data(), l.size() + 1, h); // avec le '\0'
+  for(const std::string & l : samples) h = fnv1a(l.data(), l.size() + 1, h);
+  return h;
+}
+
+// empreinte des octets [max(0, to - 64 ko), to) du fichier
+inline uint64_t fileTailHash(const std::string & filename, uint64_t to) {
+  uint64_t from = to > (1 << 16) ? to - (1 << 16) : 0;
+  std::vector<char> buf(to - from);
+  FILE * f = fopen(filename.c_str(), "rb");
+  if(f == NULL)
+    throw std::runtime_error("Couldn't open file " + filename + "\n");
+  bool ok = fseek64(f, from) == 0 && fread(buf.data(), 1, buf.size(), f) == buf.size();
+  fclose(f);
+  if(!ok)
+    throw std::runtime_error("File read error\n");
+  return fnv1a(buf.data(), buf.size());
+}
+
+// Le VCF d'un cache, et l'endroit où reprendre sa lecture s'il a grandi :
+// resume est la taille du fichier lu, pourvu qu'il se termine par une ligne
+// complète (fichier texte) ou par le bloc de fin (fichier bgzip) ; les lignes
+// ajoutées commencent alors à resume (pour un fichier bgzip, au début d'un
+// bloc puisque les fichiers bgzip se mettent bout à bout). resume = 0 : le
+// fichier ne peut être que relu en entier (gzip, lecture pendant une écriture...)
+// tail (cf fileTailHash) permet de vérifier que le début n'a pas changé
+struct VCFstamp {
+  uint64_t size;
+  int64_t mtime;
+  uint64_t fingerprint; // cf headerFingerprint
+  uint64_t resume;
+  uint64_t tail;
+};
+
+// à appeler après la lecture des size premiers octets du fichier (cf la limite
+// de VCFreader), avec sa taille et sa date d'avant la lecture. Des lignes
+// ajoutées pendant la lecture n'ont pas été lues : elles le seront à partir
+// de resume, le cache ne correspondant plus au fichier
+inline VCFstamp makeVCFstamp(const std::string & filename, uint64_t size, int64_t mtime,
+                             const std::vector<std::string> & header, const std::vector<std::string> & samples) {
+  VCFstamp st = {size, mtime, headerFingerprint(header, samples), 0, 0};
+  uint64_t s;
+  int64_t t;
+  if(!fileStamp(filename, s, t) || s < size || size == 0)
+    return st; // le fichier a été raccourci ou remplacé pendant la lecture
+  // la fin du fichier : le dernier octet, ou le bloc de fin d'un fichier bgzip
+  static const unsigned char bgzfEOF[28] = {31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 66, 67,
+                                            2, 0, 27, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  int type = compressionType(filename);
+  size_t n = type == 1 ? 1 : 28;
+  if((type != 1 && type != 3) || size < n)
+    return st;
+  unsigned char last[28];
+  FILE * f = fopen(filename.c_str(), "rb");
+  if(f == NULL)
+    return st;
+  // les octets de [size - n, size), même si le fichier a grandi depuis
+  bool ok = fseek64(f, size - n) == 0 && fread(last, 1, n, f) == n;
+  fclose(f);
+  if(ok && (type == 1 ? last[0] == '\n' : memcmp(last, bgzfEOF, 28) == 0)) {
+    st.resume = size;
+    st.tail = fileTailHash(filename, size);
+  }
+  return st;
+}
+
+// écriture ------------------------------------------------------------
+class VCFcacheWriter {
+  private:
+
+  FILE * f;
+  uint64_t pos;
+
+  void write(const void * p, size_t n) {
+    if(n > 0 && fwrite(p, 1, n, f) != n)
+      throw std::runtime_error("Couldn't write VCF cache\n");
+    pos += n;
+  }
+
+  void u64(uint64_t x) {
+    write(&x, 8);
+  }
+
+  void pad() {
+    static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    write(zeros, (8 - pos % 8) % 8);
+  }
+
+  public:
+  explicit VCFcacheWriter(const std::string & path) : pos(0) {
+    f = fopen(path.c_str(), "wb");
+    if(f == NULL)
+      throw std::runtime_error("Couldn't create VCF cache " + path + "\n");
+  }
+
+  ~VCFcacheWriter() {
+    if(f != NULL) fclose(f);
+  }
+
+  VCFcacheWriter(const VCFcacheWriter &) = delete;
+  VCFcacheWriter & operator=(const VCFcacheWriter &) = delete;
+
+  void header(const VCFstamp & st, uint64_t nsnps, uint64_t nsamples) {
+    write(VCFcacheMagic, 8);
+    u64(st.size);
+    write(&st.mtime, 8);
+    u64(nsnps);
+    u64(nsamples);
+    u64(st.fingerprint);
+    u64(st.resume);
+    u64(st.tail);
+  }
+
+  void arena(const stringArena & A) {
+    u64(A.size());
+    for(size_t i = 0; i <= A.size(); i++) u64(A.offset(i));
+    write(A.bytes().data(), A.bytes().size());
+    pad();
+  }
+
+  // le même format qu'une stringArena : les doublons sont écrits en entier
+  void arena(const internedArena & A) {
+    size_t n = A.size();
+    u64(n);
+    std::vector<uint64_t> off;
+    off.reserve(4096);
+    uint64_t o = 0;
+    for(size_t i = 0; i <= n; i++) {
+      off.push_back(o);
+      if(i < n) o += A[i].size();
+      if(off.size() == 4096 || i == n) {
+        write(off.data(), 8 * off.size());
+        off.clear();
+      }
+    }
+    std::string buf;
+    for(size_t i = 0; i < n; i++) {
+      charSpan s = A[i];
+      buf.append(s.begin, s.end);
+      if(buf.size() >= (1 << 20) || i + 1 == n) {
+        write(buf.data(), buf.size());
+        buf.clear();
+      }
+    }
+    pad();
+  }
+
+  void strings(const std::vector<std::string> & x) {
+    stringArena A;
+    for(const std::string & s : x) A.push_back(s);
+    arena(A);
+  }
+
+  void ints(const std::vector<int> & x) {
+    u64(x.size());
+    std::vector<int32_t> y(x.begin(), x.end());
+    write(y.data(), 4 * y.size());
+    pad();
+  }
+
+  void genotypes(const packedGenotypes & G) {
+    u64(G.rowBytes());
+    for(size_t i = 0; i < G.nSNPs(); i++) write(G.row(i), G.rowBytes());
+    pad();
+  }
+
+  void close() {
+    int r = fclose(f);
+    f = NULL;
+    if(r != 0)
+      throw std::runtime_error("Couldn't write VCF cache\n");
+  }
+};
+
+// écrit le cache dans path (via un fichier temporaire, renommé à la fin)
+// V doit être complète (variantTable(true))
+inline void writeVCFcache(const std::string & path, const VCFstamp & st, const std::vector<std::string> & samples,
+                          const variantTable & V, const packedGenotypes & G) {
+  std::string tmp = path + ".tmp";
+  {
+    VCFcacheWriter W(tmp);
+    W.header(st, V.size(), samples.size());
+    W.strings(samples);
+    W.strings(V.contigs.contigs());
+    W.ints(V.chr);
+    W.ints(V.pos);
+    W.arena(V.id);
+    W.arena(V.ref);
+    W.arena(V.alt);
+    W.genotypes(G);
+    W.close();
+  }
+  // rename remplace path d'un coup (un lecteur voit l'ancien cache ou le
+  // nouveau) ; sous Windows, il échoue si path existe
+#ifdef _WIN32
+  remove(path.c_str());
+#endif
+  if(rename(tmp.c_str(), path.c_str()) != 0) {
+    remove(tmp.c_str());
+    throw std::runtime_error("Couldn't write VCF cache " + path + "\n");
+  }
+}
+
+// lecture -------------------------------------------------------------
+// une arena dans le cache projeté
+struct cachedArena {
+  size_t n;
+  const uint64_t * offsets;
+  const char * data;
+
+  charSpan operator[](size_t i) const {
+    return charSpan(data + offsets[i], data + offsets[i + 1]);
+  }
+
+  std::vector<std::string> strings() const {
+    std::vector<std::string> x;
+    for(size_t i = 0; i < n; i++) x.push_back((*this)[i].str());
+    return x;
+  }
+};
+
+class VCFcache {
+  private:
+
+  std::unique_ptr<mmapFile> map;
+  const char * p; // position de lecture dans map lors de l'ouverture
+
+  void need(size_t n) {
+    if((size_t) (map->end() - p) < n)
+      throw std::runtime_error("Truncated VCF cache\n");
+  }
+
+  uint64_t u64() {
+    need(8);
+    uint64_t x;
+    memcpy(&x, p, 8);
+    p += 8;
+    return x;
+  }
+
+  void align() {
+    size_t o = (p - map->begin()) % 8;
+    if(o) p += 8 - o;
+  }
+
+  cachedArena arena() {
+    cachedArena A;
+    A.n = u64();
+    need(8 * (A.n + 1));
+    A.offsets = (const uint64_t *) p;
+    p += 8 * (A.n + 1);
+    A.data = p;
+    need(A.offsets[A.n]);
+    p += A.offsets[A.n];
+    align();
+    return A;
+  }
+
+  const int32_t * ints(size_t n) {
+    if(u64() != n)
+      throw std::runtime_error("Corrupted VCF cache\n");
+    need(4 * n);
+    const int32_t * x = (const int32_t *) p;
+    p += 4 * n;
+    align();
+    return x;
+  }
+
+  public:
+  uint64_t size;   // du VCF d'origine
+  int64_t mtime;
+  uint64_t fingerprint, resume, tail; // cf VCFstamp
+  size_t nsnps, nsamples;
+  cachedArena samples, contigs, id, ref, alt;
+  const int32_t * chr; // codes dans contigs (à partir de 0)
+  const int32_t * pos;
+  size_t rowBytes;
+  const uint8_t * genotypes;
+
+  explicit VCFcache(const std::string & path) : map(new mmapFile(path)) {
+    p = map->begin();
+    need(8);
+    if(memcmp(p, VCFcacheMagic, 8) != 0)
+      throw std::runtime_error("Not a readVCF cache file\n");
+    p += 8;
+    size = u64();
+    mtime = (int64_t) u64();
+    nsnps = u64();
+    nsamples = u64();
+    fingerprint = u64();
+    resume = u64();
+    tail = u64();
+    samples = arena();
+    contigs = arena();
+    chr = ints(nsnps);
+    pos = ints(nsnps);
+    id = arena();
+    ref = arena();
+    alt = arena();
+    if(samples.n != nsamples || id.n != nsnps || ref.n != nsnps || alt.n != nsnps)
+      throw std::runtime_error("Corrupted VCF cache\n");
+    rowBytes = u64();
+    if(rowBytes != (nsamples + 3) / 4)
+      throw std::runtime_error("Corrupted VCF cache\n");
+    need(rowBytes * nsnps);
+    genotypes = (const uint8_t *) p;
+  }
+
+  // le cache correspond-il au fichier (même taille, même date) ?
+  bool matches(const std::string & filename) const {
+    uint64_t s;
+    int64_t t;
+    return fileStamp(filename, s, t) && s == size && t == mtime;
+  }
+
+  // le fichier a-t-il seulement grandi depuis ? (il faut encore vérifier que
+  // l'en-tête est le même, cf fingerprint) ; les nouvelles lignes commencent à resume
+  bool appended(const std::string & filename) const {
+    uint64_t s;
+    int64_t t;
+    return resume > 0 && fileStamp(filename, s, t) && s > resume && fileTailHash(filename, resume) == tail;
+  }
+
+  // recopie les variants et les génotypes du cache à la fin de V (complète,
+  // cf variantTable(true)) et de G, pour leur ajouter les nouvelles lignes
+  void load(variantTable & V, packedGenotypes & G) const {
+    std::vector<int> codes;
+    for(size_t i = 0; i < contigs.n; i++) codes.push_back(V.contigs.code(contigs[i]));
+    V.reserve(V.size() + nsnps);
+    for(size_t i = 0; i < nsnps; i++) {
+      V.id.push_back(id[i]);
+      V.chr.push_back(codes[chr[i]]);
+      V.pos.push_back(pos[i]);
+      V.ref.push_back(ref[i]);
+      V.alt.push_back(alt[i]);
+    }
+    G.appendRows(row(0), nsnps);
+  }
+
+  const uint8_t * row(size_t snp) const {
+    return genotypes + snp * rowBytes;
+  }
+
+  template<typename scalar>
+  void decodeSNP(size_t snp, scalar * dest, size_t stride) const {
+    const uint8_t * r = row(snp);
+    for(size_t j = 0; j < nsamples; j++)
+      dest[j * stride] = (r[j >> 2] >> ((j & 3) << 1)) & 3;
+  }
+};
+
+#endif
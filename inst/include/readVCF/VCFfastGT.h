@@ -0,0 +1,100 @@
+#include <cstdint>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#ifndef _VCFfastGT_
+#define _VCFfastGT_
+
+// Décodage rapide de la partie samples d'une ligne dont le FORMAT est "GT",
+// avec des génotypes diploïdes de 3 caractères : "0/0\t0/1\t1|1\t./.\t..."
+// chaque sample occupe 4 octets. Les allèles doivent être '0', '1' ou '.'
+// et le séparateur '/' ou '|' ; le résultat est alors celui de VCFstringToGeno.
+// Le décodage s'arrête au premier sample qui n'a pas cette forme.
+
+// un sample p[0..2], true si p a la forme attendue
+inline bool fastGT1(const char * p, uint8_t & g) {
+  char a = p[0], s = p[1], b = p[2];
+  if((a != '0' && a != '1' && a != '.') || (b != '0' && b != '1' && b != '.') || (s != '/' && s != '|'))
+    return false;
+  g = (a == '.' || b == '.') ? 3 : (a == '1') + (b == '1');
+  return true;
+}
+
+// les génotypes des 4 samples d'un bloc de 16 octets, d'après les masques
+// (un bit par octet) des '1' et des '.'
+inline void fastGTmasks(unsigned ones, unsigned dots, uint8_t * g) {
+  for(int k = 0; k < 4; k++) {
+    unsigned o = ones >> (4*k), d = dots >> (4*k);
+    g[k] = (d & 5) ? 3 : (o & 1) + ((o >> 2) & 1);
+  }
+}
+
+#if defined(__SSE2__)
+// 16 octets = 4 samples "a/b\t", true si le bloc a la forme attendue
+inline bool fastGT4(const char * p, uint8_t * g) {
+  __m128i v = _mm_loadu_si128((const __m128i *) p);
+  unsigned ones = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('1')));
+  unsigned dots = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('.')));
+  unsigned zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('0')));
+  unsigned seps = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')),
+                                                 _mm_cmpeq_epi8(v, _mm_set1_epi8('|'))));
+  unsigned tabs = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+  // allèles en 0, 2 (mod 4), séparateur en 1, tabulation en 3
+  if(((ones | dots | zeros) & 0x5555) != 0x5555 || (seps & 0x2222) != 0x2222 || (tabs & 0x8888) != 0x8888)
+    return false;
+  fastGTmasks(ones, dots, g);
+  return true;
+}
+#define FASTGT4
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+inline unsigned fastGTmovemask(uint8x16_t v) {
+  const uint8x16_t w = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t t = vandq_u8(v, w);
+  return vaddv_u8(vget_low_u8(t)) | (vaddv_u8(vget_high_u8(t)) << 8);
+}
+
+inline bool fastGT4(const char * p, uint8_t * g) {
+  uint8x16_t v = vld1q_u8((const uint8_t *) p);
+  unsigned ones = fastGTmovemask(vceqq_u8(v, vdupq_n_u8('1')));
+  unsigned dots = fastGTmovemask(vceqq_u8(v, vdupq_n_u8('.')));
+  unsigned zeros = fastGTmovemask(vceqq_u8(v, vdupq_n_u8('0')));
+  unsigned seps = fastGTmovemask(vorrq_u8(vceqq_u8(v, vdupq_n_u8('/')), vceqq_u8(v, vdupq_n_u8('|'))));
+  unsigned tabs = fastGTmovemask(vceqq_u8(v, vdupq_n_u8('\t')));
+  if(((ones | dots | zeros) & 0x5555) != 0x5555 || (seps & 0x2222) != 0x2222 || (tabs & 0x8888) != 0x8888)
+    return false;
+  fastGTmasks(ones, dots, g);
+  return true;
+}
+#define FASTGT4
+#endif
+
+// décode les samples de [b, e) tant qu'ils ont la forme attendue,
+// out(g) est appelé pour chacun ; renvoie le début du premier sample
+// non décodé (e si tout a été décodé)
+template<typename F>
+inline const char * fastGT(const char * b, const char * e, F out) {
+  uint8_t g[4];
+#ifdef FASTGT4
+  while(e - b >= 16 && fastGT4(b, g)) {
+    out(g[0]);
+    out(g[1]);
+    out(g[2]);
+    out(g[3]);
+    b += 16;
+  }
+#endif
+  while(e - b >= 4 && b[3] == '\t' && fastGT1(b, g[0])) {
+    out(g[0]);
+    b += 4;
+  }
+  if(e - b == 3 && fastGT1(b, g[0])) { // le dernier sample
+    out(g[0]);
+    b = e;
+  }
+  return b;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include <cstring>
+#include <string>
+#include <cmath>
+#include <stdexcept>
+#include "constStringStreamLite.h"
+#include "tokenAtPosition.h"
+#include "VCFstringToGeno.h"
+#include "VCFsnpInfo.h"
+#include "formatCache.h"
+
+#ifndef _VCFfield_
+#define _VCFfield_
+
+// Décodage d'un champ des samples, spécialisé à la compilation sur le type
+// du champ et sur le type du résultat : la boucle sur les samples ne
+// contient plus que la recherche des séparateurs et la conversion
+enum fieldKind { GENOTYPE_FIELD, INTEGER_FIELD, FLOAT_FIELD };
+
+template<fieldKind K, typename scalar>
+struct fieldParser;
+
+// GT : 0, 1, 2, et 3 pour NA (cf VCFstringToGeno)
+template<typename scalar>
+struct fieldParser<GENOTYPE_FIELD, scalar> {
+  static scalar parse(const char * b, const char * e, scalar) {
+    return VCFstringToGeno<scalar>(b, e - b);
+  }
+};
+
+// DP, GQ... ; na pour "." ou une valeur absente
+template<typename scalar>
+struct fieldParser<INTEGER_FIELD, scalar> {
+  static scalar parse(const char * b, const char * e, scalar na) {
+    if(b == e || (e - b == 1 && *b == '.')) return na;
+    return (scalar) spanToInt(b, e);
+  }
+};
+
+// DS... ; na pour "." ou une valeur absente
+template<typename scalar>
+struct fieldParser<FLOAT_FIELD, scalar> {
+  static scalar parse(const char * b, const char * e, scalar na) {
+    double x = spanToDouble(b, e);
+    return std::isnan(x) ? na : (scalar) x;
+  }
+};
+
+// le champ numéro pos de chaque sample des colonnes [b, e) (séparées par des
+// tabulations), écrit dans dest[j * stride] ; renvoie le nombre de samples lus
+// !! erreurs signalées par std::runtime_error (pas d'API R) !!
+template<fieldKind K, typename scalar>
+size_t VCFsampleValues(const char * b, const char * e, int pos, size_t nsamples, scalar * dest, size_t stride, scalar na) {
+  size_t j = 0;
+  while(b < e) {
+    const char * t = (const char *) memchr(b, '\t', e - b);
+    if(t == NULL) t = e;
+    if(j == nsamples)
+      throw std::runtime_error("VCF file format error (too many genotypes)");
+    charSpan v = tokenAtPosition(b, t, pos);
+    dest[j++ * stride] = fieldParser<K, scalar>::parse(v.begin, v.end, na);
+    b = t + 1;
+  }
+  return j;
+}
+
+// une ligne de VCF : le champ field de chaque sample, cf VCFsampleValues
+// (na pour tous les samples si le champ n'est pas dans le FORMAT)
+template<fieldKind K, typename chrT, typename strT, typename scalar>
+void VCFlineField(const char * begin, const char * end, VCFsnpInfo<chrT, strT> & snp, const std::string & field,
+                  scalar * dest, size_t stride, size_t nsamples, formatCache & formats, scalar na) {
+  constStringStreamLite li(begin, end, 9); // 9 = tab separated
+  charSpan format;
+  if(!(li >> snp.chr >> snp.pos >> snp.id >> snp.ref >> snp.alt >> snp.qual >> snp.filter >> snp.info >> format)) {
+    throw std::runtime_error("VCF file format error");
+  }
+  int pos = fieldPosition(formats.get(format), field);
+  size_t j = 0;
+  if(pos != -1) {
+    charSpan rest = li.rest();
+    j = VCFsampleValues<K>(rest.begin, rest.end, pos, nsamples, dest, stride, na);
+    if(j < nsamples)
+      throw std::runtime_error("VCF file format error (too few genotypes)");
+  }
+  for(; j < nsamples; j++) dest[j * stride] = na;
+}
+
+#endif
@@ -0,0 +1,106 @@
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include "constStringStreamLite.h"
+#include "tokenAtPosition.h"
+#include "VCFsnpInfo.h"
+#include "formatCache.h"
+
+#ifndef _VCFgenoDecoder_
+#define _VCFgenoDecoder_
+
+// Décodage complet d'un GT : allèles sur plusieurs chiffres ("10/1"),
+// toutes ploïdies ("0/1/1"), phase ("0|1"), valeurs manquantes (".")
+// Les caractères sont classés par une table, une seule boucle sans cas
+// particuliers ; VCFstringToGeno reste le décodeur rapide des GT bialléliques
+
+enum gtCharClass { GT_OTHER = 0, GT_DIGIT = 1, GT_DOT = 2, GT_UNPHASED = 3, GT_PHASED = 4 };
+
+struct gtCharTable {
+  uint8_t c[256];
+  gtCharTable() {
+    memset(c, GT_OTHER, 256);
+    for(int i = '0'; i <= '9'; i++) c[i] = GT_DIGIT;
+    c[(int) '.'] = GT_DOT;
+    c[(int) '/'] = GT_UNPHASED;
+    c[(int) '|'] = GT_PHASED;
+  }
+};
+
+inline const gtCharTable & gtChars() {
+  static const gtCharTable T;
+  return T;
+}
+
+// les allèles du GT [b, e) dans alleles[0..maxPloidy) (-1 = manquant)
+// renvoie la ploïdie (0 si le GT est vide ou mal formé, et alors
+// il est traité comme manquant) ; phased = tous les séparateurs sont '|'
+inline int decodeGT(const char * b, const char * e, int * alleles, int maxPloidy, bool & phased) {
+  const uint8_t * cl = gtChars().c;
+  int n = 0, a = 0;
+  bool inAllele = false, dot = false;
+  phased = true;
+  for(; b < e; b++) {
+    switch(cl[(uint8_t) *b]) {
+      case GT_DIGIT:
+        a = 10*a + (*b - '0');
+        inAllele = true;
+        break;
+      case GT_DOT:
+        dot = inAllele = true;
+        break;
+      case GT_UNPHASED:
+        phased = false;
+        // no break
+      case GT_PHASED:
+        if(!inAllele || n == maxPloidy) return 0;
+        alleles[n++] = dot ? -1 : a;
+        a = 0;
+        inAllele = dot = false;
+        break;
+      default:
+        return 0;
+    }
+  }
+  if(!inAllele || n == maxPloidy) return 0;
+  alleles[n++] = dot ? -1 : a;
+  return n;
+}
+
+// les GT d'une ligne : start(nalt) est appelé une fois les colonnes fixes lues
+// (nalt = nombre d'allèles alternatifs, 1 si ALT = "."), puis
+// out(j, alleles, ploidy, phased) pour chaque sample j (ploidy = 0 si le GT
+// est manquant ou mal formé, ou si la ligne n'a pas de GT)
+// !! erreurs signalées par std::runtime_error (pas d'API R) !!
+template<typename chrT, typename S, typename F>
+void VCFlineAlleles(const char * begin, const char * end, VCFsnpInfo<chrT, charSpan> & snp, size_t nsamples,
+                    formatCache & formats, S start, F out) {
+  const int maxPloidy = 8;
+  constStringStreamLite li(begin, end, 9); // 9 = tab separated
+  charSpan format;
+  if(!(li >> snp.chr >> snp.pos >> snp.id >> snp.ref >> snp.alt >> snp.qual >> snp.filter >> snp.info >> format)) {
+    throw std::runtime_error("VCF file format error");
+  }
+  start(1 + (int) std::count(snp.alt.begin, snp.alt.end, ','));
+
+  int pos = formats.get(format).GT;
+  int alleles[maxPloidy];
+  bool phased;
+  size_t j = 0;
+  if(pos != -1) {
+    charSpan G;
+    while(li >> G) {
+      if(j == nsamples)
+        throw std::runtime_error("VCF file format error (too many genotypes)");
+      charSpan GT = tokenAtPosition(G.begin, G.end, pos);
+      int p = decodeGT(GT.begin, GT.end, alleles, maxPloidy, phased);
+      out(j++, alleles, p, phased);
+    }
+    if(j < nsamples)
+      throw std::runtime_error("VCF file format error (too few genotypes)");
+  }
+  for(; j < nsamples; j++) out(j, alleles, 0, false);
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include <string>
+#include <vector>
+#include <utility>
+
+#ifndef _VCFheader_
+#define _VCFheader_
+
+// une ligne "##" de l'en-tête :
+//   ##fileformat=VCFv4.2            -> key = "fileformat", value = "VCFv4.2"
+//   ##INFO=<ID=DP,Number=1,...>     -> key = "INFO", fields = (ID, DP), (Number, 1)...
+// les valeurs entre guillemets sont rendues sans les guillemets
+struct VCFheaderLine {
+  std::string key;
+  std::string value;
+  std::vector< std::pair<std::string, std::string> > fields;
+
+  explicit VCFheaderLine(const std::string & line) {
+    size_t b = line.compare(0, 2, "##") == 0 ? 2 : 0;
+    size_t eq = line.find('=', b);
+    if(eq == std::string::npos) {
+      key = line.substr(b);
+      return;
+    }
+    key = line.substr(b, eq - b);
+    value = line.substr(eq + 1);
+    if(value.size() < 2 || value[0] != '<' || value[value.size() - 1] != '>')
+      return;
+    // les champs de <...>, séparés par des virgules hors guillemets
+    size_t i = 1, e = value.size() - 1;
+    while(i < e) {
+      size_t c0 = value.find(',', i);
+      if(c0 == std::string::npos || c0 > e) c0 = e;
+      size_t k = value.find('=', i);
+      if(k == std::string::npos || k > c0) { // un champ sans valeur
+        fields.push_back(std::make_pair(value.substr(i, c0 - i), std::string()));
+        i = c0 + 1;
+        continue;
+      }
+      std::string name = value.substr(i, k - i);
+      std::string val;
+      i = k + 1;
+      if(i < e && value[i] == '"') {
+        for(i++; i < e && value[i] != '"'; i++) {
+          if(value[i] == '\\' && i + 1 < e) i++;
+          val += value[i];
+        }
+        i++; // le '"' fermant
+        while(i < e && value[i] != ',') i++;
+      } else {
+        size_t c = value.find(',', i);
+        if(c == std::string::npos || c > e) c = e;
+        if(i < c) val = value.substr(i, c - i);
+        i = c;
+      }
+      fields.push_back(std::make_pair(name, val));
+      i++; // la ','
+    }
+  }
+
+  bool structured() const {
+    return !fields.empty();
+  }
+
+  // la valeur d'un champ de <...> ("" s'il est absent)
+  std::string field(const std::string & name) const {
+    for(const std::pair<std::string, std::string> & f : fields)
+      if(f.first == name) return f.second;
+    return "";
+  }
+};
+
+#endif
@@ -0,0 +1,243 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include "mmapFile.h"
+#include "tabix.h"
+#include "variantTable.h"
+#include "VCFcache.h"
+
+#ifndef _VCFindex_
+#define _VCFindex_
+
+// Index d'un VCF non compressé, à côté du fichier (filename.rvi), cf buildVCFindex :
+// les lignes de données sont découpées en blocs d'au plus step lignes consécutives
+// d'un même contig ; pour chaque bloc, l'offset (en octets) de sa première ligne,
+// son numéro (à partir de 0), le contig, la première position et la fin du
+// variant qui finit le plus loin (POS + longueur de REF - 1).
+//   en-tête : "rVCFidx" + version, taille et date de modification du VCF,
+//      step, nombre de lignes, de blocs et de contigs
+//   les noms des contigs (séparés par des '\0'), les blocs (32 octets chacun)
+// Une ligne donnée est à moins de step lignes du début de son bloc ; une région
+// ne lit que les blocs qui la chevauchent (les lignes d'un contig doivent être
+// triées par position, comme pour tabix)
+// Le format est celui de la machine (pas d'échange d'octets)
+
+static const char VCFindexMagic[8] = {'r', 'V', 'C', 'F', 'i', 'd', 'x', 1};
+
+inline std::string VCFindexFile(const std::string & filename) {
+  return filename + ".rvi";
+}
+
+struct VCFindexBlock {
+  uint64_t offset;
+  uint64_t line;
+  int32_t chr; // code dans les contigs de l'index
+  int32_t first; // POS de la première ligne
+  int32_t last; // fin du variant qui finit le plus loin
+  int32_t n; // nombre de lignes
+};
+
+// des lignes consécutives à lire : n lignes à partir de offset
+struct lineChunk {
+  uint64_t offset;
+  uint64_t n;
+};
+
+// écriture ------------------------------------------------------------
+// l'index de filename (non compressé) dans path (via un fichier temporaire) ;
+// renvoie le nombre de lignes et de blocs
+inline void writeVCFindex(const std::string & filename, const std::string & path, size_t step,
+                          size_t & nlines, size_t & nblocks) {
+  if(step < 1)
+    throw std::runtime_error("step should be positive\n");
+  if(compressionType(filename) != 1)
+    throw std::runtime_error("buildVCFindex needs an uncompressed VCF (use a tabix index for bgzip files)\n");
+  uint64_t size;
+  int64_t mtime;
+  if(!fileStamp(filename, size, mtime))
+    throw std::runtime_error("Couldn't open file\n");
+  mmapFile map(filename);
+  const char * p = map.begin();
+  const char * end = map.end();
+  // l'en-tête
+  while(p < end && *p == '#') {
+    const char * nl = (const char *) memchr(p, '\n', end - p);
+    p = (nl == NULL) ? end : nl + 1;
+  }
+
+  contigTable contigs;
+  std::vector<VCFindexBlock> blocks;
+  nlines = 0;
+  while(p < end) {
+    const char * e = (const char *) memchr(p, '\n', end - p);
+    if(e == NULL) e = end;
+    const char * t1 = (const char *) memchr(p, '\t', e - p);
+    if(t1 == NULL)
+      throw std::runtime_error("VCF file format error (line " + std::to_string(nlines + 1) + ")\n");
+    int chr = contigs.code(charSpan(p, t1));
+    const char * q = t1 + 1;
+    int64_t pos = 0;
+    for(; q < e && *q >= '0' && *q <= '9'; q++) pos = 10*pos + (*q - '0');
+    // la fin du variant, d'après la longueur de REF (cf lineInRegion)
+    int64_t rlen = 1;
+    const char * t3 = (q < e) ? (const char *) memchr(q + 1, '\t', e - q - 1) : NULL;
+    if(t3 != NULL) {
+      const char * t4 = (const char *) memchr(t3 + 1, '\t', e - t3 - 1);
+      if(t4 != NULL) rlen = t4 - t3 - 1;
+    }
+    int64_t last = pos + std::max(rlen, (int64_t) 1) - 1;
+    if(pos > INT32_MAX || last > INT32_MAX)
+      throw std::runtime_error("Position too large for the index\n");
+    if(blocks.empty() || blocks.back().chr != chr || blocks.back().n == (int32_t) step) {
+      VCFindexBlock B = {(uint64_t) (p - map.begin()), nlines, chr, (int32_t) pos, (int32_t) last, 0};
+      blocks.push_back(B);
+    }
+    VCFindexBlock & B = blocks.back();
+    B.last = std::max(B.last, (int32_t) last);
+    B.n++;
+    nlines++;
+    p = (e == end) ? end : e + 1;
+  }
+  nblocks = blocks.size();
+
+  std::string names;
+  for(const std::string & s : contigs.contigs()) {
+    names += s;
+    names += '\0';
+  }
+  names.resize((names.size() + 7) & ~(size_t) 7, '\0');
+  uint64_t H[7] = {size, (uint64_t) mtime, step, nlines, nblocks, contigs.contigs().size(), names.size()};
+
+  std::string tmp = path + ".tmp";
+  FILE * f = fopen(tmp.c_str(), "wb");
+  if(f == NULL)
+    throw std::runtime_error("Couldn't create index " + path + "\n");
+  bool ok = fwrite(VCFindexMagic, 1, 8, f) == 8 && fwrite(H, 8, 7, f) == 7
+    && fwrite(names.data(), 1, names.size(), f) == names.size()
+    && fwrite(blocks.data(), sizeof(VCFindexBlock), blocks.size(), f) == blocks.size();
+  ok = (fclose(f) == 0) && ok;
+  if(ok) {
+    // cf writeVCFcache : pas de remove, sauf sous Windows
+#ifdef _WIN32
+    remove(path.c_str());
+#endif
+    ok = rename(tmp.c_str(), path.c_str()) == 0;
+  }
+  if(!ok) {
+    remove(tmp.c_str());
+    throw std::runtime_error("Couldn't write index " + path + "\n");
+  }
+}
+
+// lecture -------------------------------------------------------------
+class VCFindex {
+  private:
+
+  std::unique_ptr<mmapFile> map;
+  std::vector<std::string> names;
+  const VCFindexBlock * blocks;
+
+  public:
+  uint64_t size; // du VCF
+  int64_t mtime;
+  size_t step, nlines, nblocks;
+
+  explicit VCFindex(const std::string & path) : map(new mmapFile(path)) {
+    const char * p = map->begin();
+    if(map->size() < 64 || memcmp(p, VCFindexMagic, 8) != 0)
+      throw std::runtime_error("Not a readVCF index file\n");
+    uint64_t H[7];
+    memcpy(H, p + 8, 56);
+    size = H[0];
+    mtime = (int64_t) H[1];
+    step = H[2];
+    nlines = H[3];
+    nblocks = H[4];
+    size_t ncontigs = H[5], nbytes = H[6];
+    if(map->size() != 64 + nbytes + nblocks * sizeof(VCFindexBlock))
+      throw std::runtime_error("Corrupted VCF index\n");
+    const char * s = p + 64;
+    for(size_t i = 0; i < ncontigs; i++) {
+      const char * z = (const char *) memchr(s, '\0', p + 64 + nbytes - s);
+      if(z == NULL)
+        throw std::runtime_error("Corrupted VCF index\n");
+      names.push_back(std::string(s, z));
+      s = z + 1;
+    }
+    blocks = (const VCFindexBlock *) (p + 64 + nbytes);
+  }
+
+  // l'index correspond-il au fichier (même taille, même date) ?
+  bool matches(const std::string & filename) const {
+    uint64_t s;
+    int64_t t;
+    return fileStamp(filename, s, t) && s == size && t == mtime;
+  }
+
+  // le code d'un contig dans l'index, -1 s'il n'y est pas
+  int refId(const std::string & chr) const {
+    for(size_t i = 0; i < names.size(); i++) if(names[i] == chr) return i;
+    return -1;
+  }
+
+  // le bloc qui contient la ligne line (le dernier si line >= nlines)
+  const VCFindexBlock & blockOf(uint64_t line) const {
+    if(nblocks == 0)
+      throw std::runtime_error("Empty VCF index\n");
+    const VCFindexBlock * b = std::upper_bound(blocks, blocks + nblocks, line,
+      [](uint64_t l, const VCFindexBlock & B) { return l < B.line; });
+    return b == blocks ? blocks[0] : b[-1];
+  }
+
+  // les lignes à lire pour une région (les blocs qui la chevauchent, fusionnés
+  // quand ils se suivent) ; il reste à vérifier chaque ligne (cf lineInRegion)
+  std::vector<lineChunk> query(const genomicRegion & r) const {
+    std::vector<lineChunk> res;
+    int chr = refId(r.chr);
+    if(chr < 0) return res;
+    size_t prev = nblocks;
+    for(size_t i = 0; i < nblocks; i++) {
+      const VCFindexBlock & B = blocks[i];
+      if(B.chr != chr || B.first > r.end || B.last < r.beg) continue;
+      if(prev + 1 == i) {
+        res.back().n += B.n;
+      } else {
+        lineChunk c = {B.offset, (uint64_t) B.n};
+        res.push_back(c);
+      }
+      prev = i;
+    }
+    return res;
+  }
+};
+
+// l'index de filename s'il existe et correspond au fichier, sinon NULL
+// (stale = true s'il existe mais que le fichier a changé depuis, ou s'il
+// est illisible : error, si non NULL, reçoit alors le message de VCFindex)
+inline std::unique_ptr<VCFindex> openVCFindex(const std::string & filename, bool & stale, std::string * error = NULL) {
+  std::unique_ptr<VCFindex> idx;
+  stale = false;
+  uint64_t s;
+  int64_t t;
+  std::string path = VCFindexFile(filename);
+  if(!fileStamp(path, s, t)) return idx;
+  try {
+    idx.reset(new VCFindex(path));
+  } catch(std::exception & e) {
+    stale = true;
+    if(error) *error = e.what();
+    return idx;
+  }
+  if(!idx->matches(filename)) {
+    idx.reset();
+    stale = true;
+  }
+  return idx;
+}
+
+#endif
@@ -0,0 +1,55 @@
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include "constStringStreamLite.h"
+#include "tokenAtPosition.h"
+#include "VCFsnpInfo.h"
+#include "formatCache.h"
+
+#ifndef _VCFlineDosages_
+#define _VCFlineDosages_
+
+// les valeurs numériques du champ field (DS, GP, ...) d'une ligne de VCF :
+// nval valeurs par sample (1 pour DS, 3 pour GP), séparées par des virgules
+// out(j, k, x) est appelé pour la valeur k du sample j ; x = NAN pour
+// une valeur manquante ("." ou absente, ou champ absent du FORMAT)
+// les nombres sont lus par spanToDouble, sans copie
+// !! erreurs signalées par std::runtime_error (pas d'API R) !!
+template<typename chrT, typename strT, typename F>
+void VCFlineDosages(const char * begin, const char * end, VCFsnpInfo<chrT, strT> & snp, const std::string & field,
+                    int nval, size_t nsamples, formatCache & formats, F out) {
+  constStringStreamLite li(begin, end, 9); // 9 = tab separated
+  charSpan format;
+  if(!(li >> snp.chr >> snp.pos >> snp.id >> snp.ref >> snp.alt >> snp.qual >> snp.filter >> snp.info >> format)) {
+    throw std::runtime_error("VCF file format error");
+  }
+
+  int pos = fieldPosition(formats.get(format), field);
+  size_t j = 0;
+  if(pos != -1) {
+    charSpan G;
+    while(li >> G) {
+      if(j == nsamples)
+        throw std::runtime_error("VCF file format error (too many genotypes)");
+      charSpan V = tokenAtPosition(G.begin, G.end, pos);
+      const char * b = V.begin;
+      for(int k = 0; k < nval; k++) {
+        if(b > V.end) {
+          out(j, k, NAN);
+          continue;
+        }
+        const char * c = (const char *) memchr(b, ',', V.end - b);
+        if(c == NULL) c = V.end;
+        out(j, k, spanToDouble(b, c));
+        b = c + 1;
+      }
+      j++;
+    }
+    if(j < nsamples)
+      throw std::runtime_error("VCF file format error (too few genotypes)");
+  }
+  for(; j < nsamples; j++)
+    for(int k = 0; k < nval; k++) out(j, k, NAN);
+}
+
+#endif
@@ -1,40 +1,167 @@
-#include <Rcpp.h>
 #include <iostream>
 #include <fstream>
+#include <cstring>
+#include <stdexcept>
 #include "stringStreamLite.h"
+#include "constStringStreamLite.h"
 #include "tokenPosition.h"
 #include "tokenAtPosition.h"
 #include "VCFstringToGeno.h"
+#include "VCFfastGT.h"
 #include "VCFsnpInfo.h"
+#include "packedGenotypes.h"
+#include "formatCache.h"
+#include "sampleSelection.h"
+#include "VCFfield.h"
+#include "profile.h"
 
 #ifndef _VCFlineGenotypes_
 #define _VCFlineGenotypes_
 
 // #CHROM  POS     ID      REF     ALT     QUAL    FILTER  INFO    FORMAT
 // chrT = le type pour les chromosomes
-// scalar = le type numeriques pour les genotypes
+// sink = un std::vector<scalar>, ou tout type avec value_type et push_back
+// (cf packedGenotypes) ; scalar = le type numeriques pour les genotypes
 // !! la fonction push back les SNP dans le vecteur genotypes, sans se préoccuper des données
 // !! qui peuvent déjà s'y trouver 
-template<typename chrT, typename scalar>
-void VCFlineGenotypes(std::string & line, VCFsnpInfo<chrT> & snp, std::vector<scalar> & genotypes) {
+// !! les erreurs sont signalées par std::runtime_error (pas de Rcpp::stop, la
+// !! fonction peut être appelée depuis un autre thread que celui de R)
+// la ligne [begin, end) n'est pas modifiée (elle peut être dans un fichier mappé)
+// formats = la position de GT dans les FORMAT déjà rencontrés (un cache par thread)
+// keep = les samples à décoder : les autres colonnes sont sautées sans être lues
+// (recherche de la tabulation suivante), la ligne n'est pas lue au delà du dernier
+// prof (facultatif) : temps des étapes fields et genotypes, cf profile.h
+template<typename chrT, typename strT, typename sink>
+void VCFlineGenotypes(const char * begin, const char * end, VCFsnpInfo<chrT, strT> & snp, sink & genotypes, formatCache & formats,
+                      const sampleSelection & keep, profileCounters * prof = NULL) {
+  typedef typename sink::value_type scalar;
+  if(prof) prof->start();
 
-  stringStreamLite li(line, 9); // 9 = tab separated
-  std::string format;
+  constStringStreamLite li(begin, end, 9); // 9 = tab separated
+  charSpan format;
   if(!(li >> snp.chr >> snp.pos >> snp.id >> snp.ref >> snp.alt >> snp.qual >> snp.filter >> snp.info >> format)) {
-    Rcpp::stop("VCF file format error");
+    throw std::runtime_error("VCF file format error");
   }
   
-  int pos = tokenPosition(format, "GT");
-  if(pos != -1) {
-    std::string G;
+  const formatLayout & layout = formats.get(format);
+  int pos = layout.GT;
+  if(prof) prof->lap(prof->fieldsNs);
+  if(pos != -1 && !keep.all()) {
+    charSpan rest = li.rest();
+    const char * p = rest.begin;
+    for(size_t j = 0; j < keep.end() && p <= rest.end; j++) {
+      const char * t = (const char *) memchr(p, '\t', rest.end - p);
+      if(t == NULL) t = rest.end;
+      if(keep.keep(j)) {
+        charSpan GT = tokenAtPosition(p, t, pos);
+        genotypes.push_back(VCFstringToGeno<scalar>(GT.begin, GT.size()));
+      }
+      p = t + 1;
+    }
+  } else if(pos != -1) {
+    if(layout.gtOnly) {
+      // le cas le plus courant, cf VCFfastGT.h ; on reprend la boucle
+      // générale au premier sample qui n'a pas la forme attendue
+      charSpan rest = li.rest();
+      const char * r = fastGT(rest.begin, rest.end, [&genotypes](uint8_t g) { genotypes.push_back((scalar) g); });
+      li = constStringStreamLite(r, rest.end, 9);
+    }
+    charSpan G;
     while(li >> G) {
-      // conversion du token t1 en génotype
-      std::string GT( tokenAtPosition<std::string>(G, pos) );
-      scalar g = VCFstringToGeno<scalar>(GT);
+      // conversion du token G en génotype
+      charSpan GT = tokenAtPosition(G.begin, G.end, pos);
+      scalar g = VCFstringToGeno<scalar>(GT.begin, GT.size());
       genotypes.push_back(g);
     }
   }
+  if(prof) prof->lap(prof->genotypesNs);
+}
+
+template<typename chrT, typename strT, typename sink>
+inline void VCFlineGenotypes(const char * begin, const char * end, VCFsnpInfo<chrT, strT> & snp, sink & genotypes, formatCache & formats) {
+  VCFlineGenotypes(begin, end, snp, genotypes, formats, sampleSelection());
+}
+
+template<typename chrT, typename strT, typename sink>
+inline void VCFlineGenotypes(const char * begin, const char * end, VCFsnpInfo<chrT, strT> & snp, sink & genotypes) {
+  formatCache formats;
+  VCFlineGenotypes(begin, end, snp, genotypes, formats);
 }
 
+template<typename chrT, typename strT, typename sink>
+inline void VCFlineGenotypes(const char * line, VCFsnpInfo<chrT, strT> & snp, sink & genotypes) {
+  VCFlineGenotypes(line, line + strlen(line), snp, genotypes);
+}
+
+template<typename chrT, typename strT, typename sink>
+inline void VCFlineGenotypes(const std::string & line, VCFsnpInfo<chrT, strT> & snp, sink & genotypes) {
+  VCFlineGenotypes(line.data(), line.data() + line.size(), snp, genotypes);
+}
+
+
+// la même chose, mais en écrivant les génotypes directement à leur place
+// dans la matrice finale (column-major) : dest pointe sur la case du premier
+// sample, stride = nombre de lignes de la matrice (le nombre de SNPs)
+// si la ligne n'a pas de champ GT, les génotypes sont mis à 3 (NA)
+// avec une sélection keep, nsamples est le nombre de samples gardés
+// prof : cf la version précédente
+template<typename chrT, typename strT, typename scalar>
+void VCFlineGenotypes(const char * begin, const char * end, VCFsnpInfo<chrT, strT> & snp, scalar * dest, size_t stride, size_t nsamples,
+                      formatCache & formats, const sampleSelection & keep, profileCounters * prof = NULL) {
+  if(prof) prof->start();
+
+  constStringStreamLite li(begin, end, 9); // 9 = tab separated
+  charSpan format;
+  if(!(li >> snp.chr >> snp.pos >> snp.id >> snp.ref >> snp.alt >> snp.qual >> snp.filter >> snp.info >> format)) {
+    throw std::runtime_error("VCF file format error");
+  }
+
+  const formatLayout & layout = formats.get(format);
+  int pos = layout.GT;
+  if(prof) prof->lap(prof->fieldsNs);
+  size_t j = 0;
+  if(pos != -1 && !keep.all()) {
+    charSpan rest = li.rest();
+    const char * p = rest.begin;
+    for(size_t k = 0; k < keep.end() && p <= rest.end; k++) {
+      const char * t = (const char *) memchr(p, '\t', rest.end - p);
+      if(t == NULL) t = rest.end;
+      if(keep.keep(k)) {
+        charSpan GT = tokenAtPosition(p, t, pos);
+        dest[j++ * stride] = VCFstringToGeno<scalar>(GT.begin, GT.size());
+      }
+      p = t + 1;
+    }
+    if(j < nsamples)
+      throw std::runtime_error("VCF file format error (too few genotypes)");
+  } else if(pos != -1) {
+    charSpan rest = li.rest();
+    const char * r = rest.begin;
+    if(layout.gtOnly) {
+      r = fastGT(rest.begin, rest.end, [&](uint8_t g) {
+        if(j == nsamples)
+          throw std::runtime_error("VCF file format error (too many genotypes)");
+        dest[j++ * stride] = g;
+      });
+    }
+    j += VCFsampleValues<GENOTYPE_FIELD>(r, rest.end, pos, nsamples - j, dest + j * stride, stride, (scalar) 3);
+    if(j < nsamples)
+      throw std::runtime_error("VCF file format error (too few genotypes)");
+  }
+  for(; j < nsamples; j++) dest[j * stride] = 3;
+  if(prof) prof->lap(prof->genotypesNs);
+}
+
+template<typename chrT, typename strT, typename scalar>
+inline void VCFlineGenotypes(const char * begin, const char * end, VCFsnpInfo<chrT, strT> & snp, scalar * dest, size_t stride, size_t nsamples,
+                             formatCache & formats) {
+  VCFlineGenotypes(begin, end, snp, dest, stride, nsamples, formats, sampleSelection());
+}
+
+template<typename chrT, typename strT, typename scalar>
+inline void VCFlineGenotypes(const std::string & line, VCFsnpInfo<chrT, strT> & snp, scalar * dest, size_t stride, size_t nsamples) {
+  formatCache formats;
+  VCFlineGenotypes(line.data(), line.data() + line.size(), snp, dest, stride, nsamples, formats);
+}
 
 #endif
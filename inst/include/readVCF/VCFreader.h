@@ -0,0 +1,345 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include "lineReader.h"
+#include "mmapFile.h"
+#include "tabix.h"
+#include "VCFindex.h"
+#include "bgzf.h"
+#include "readVCFsamples.h"
+#include "parallelLines.h"
+#include "countNewlines.h"
+#include "profile.h"
+
+#ifndef _VCFreader_
+#define _VCFreader_
+
+// ouvre un VCF, lit l'en-tête et les noms des samples,
+// puis donne les lignes de données : tout le fichier, ou seulement
+// les régions demandées (fichier bgzip avec un index tabix, ou fichier
+// non compressé avec un index de readVCF, cf VCFindex.h), ou un intervalle
+// de lignes (cf lineRange)
+// Un fichier non compressé peut être projeté en mémoire (useMmap) ; sans
+// régions, les lignes de données sont alors directement accessibles entre
+// dataBegin() et dataEnd(), sans copie
+// Un fichier bgzip est décompressé par threads threads, ou par pool quand il
+// est donné : celui qui traite les lignes (cf parallelLines), pour ne pas
+// avoir deux pools. pool doit survivre au lecteur
+// limit : rien n'est lu au-delà de l'octet limit du fichier (pour un fichier
+// bgzip, le dernier bloc entier), cf lineReader ; pour lire un fichier tel
+// qu'il était à un moment donné pendant qu'on lui ajoute des lignes
+class VCFreader {
+  private:
+
+  std::string filename;
+  int type; // cf compressionType
+  int threads;
+  threadPool * pool; // cf le constructeur
+  uint64_t limit; // idem
+  std::vector<std::string> regions;
+  std::unique_ptr<lineReader> in;
+  std::unique_ptr<mmapFile> map;
+  const char * mpos; // position de lecture dans map
+  const char * mdata; // début des données dans map
+  const char * mend; // fin des données dans map (cf lineRange)
+  std::unique_ptr<tabixIndex> index;
+  std::unique_ptr<regionReader> rr;
+  // les régions d'un fichier non compressé, avec son index
+  std::unique_ptr<VCFindex> lindex;
+  std::vector<genomicRegion> lregions;
+  size_t lr, lc;
+  std::vector<lineChunk> lchunks;
+  uint64_t lleft; // lignes restant à lire dans le chunk en cours
+  // lineRange : les lignes rangeFirst, ..., rangeFirst + rangeLines - 1 (left : celles
+  // qui restent à lire, sans projection)
+  size_t rangeFirst, rangeLines, left;
+  profileCounters * prof; // cf profile
+
+  bool readLine(const char * & b, const char * & e) {
+    if(!lregions.empty()) return nextIndexedLine(b, e);
+    return rawLine(b, e);
+  }
+
+  bool rawLine(const char * & b, const char * & e) {
+    if(map) return (b = nextMappedLine(e)) != NULL;
+    if(rr) return rr->nextLine(b, e);
+    if(left == 0) return false;
+    left--;
+    return in->nextLine(b, e);
+  }
+
+  // une ligne de map, sans le '\n' final ; NULL en fin de fichier
+  const char * nextMappedLine(const char * & e) {
+    if(mpos == mend) return NULL;
+    const char * b = mpos;
+    e = (const char *) memchr(b, '\n', mend - b);
+    if(e == NULL) {
+      e = mend;
+      mpos = e;
+    } else {
+      mpos = e + 1;
+    }
+    return b;
+  }
+
+  // la ligne suivante des régions lregions, cf regionReader
+  bool nextIndexedLine(const char * & b, const char * & e) {
+    while(lr < lregions.size()) {
+      if(lleft == 0) {
+        if(lc == lchunks.size()) {
+          // région suivante
+          if(++lr < lregions.size()) lchunks = lindex->query(lregions[lr]);
+          lc = 0;
+          continue;
+        }
+        seekTo(lchunks[lc].offset);
+        lleft = lchunks[lc].n;
+        lc++;
+      }
+      bool after;
+      while(lleft > 0 && rawLine(b, e)) {
+        lleft--;
+        if(lineInRegion(b, e, lregions[lr], after)) return true;
+        if(after) {
+          lc = lchunks.size(); // inutile de lire les chunks suivants
+          break;
+        }
+      }
+      lleft = 0;
+    }
+    return false;
+  }
+
+  // reprend la lecture à offset octets du début du fichier (un début de ligne)
+  void seekTo(uint64_t offset) {
+    if(map) {
+      if(offset > map->size())
+        throw std::runtime_error("File seek error\n");
+      mpos = map->begin() + offset;
+      return;
+    }
+    in->seek(offset);
+  }
+
+  public:
+  std::vector<std::string> header; // les lignes "##"
+  std::vector<std::string> samples;
+
+  VCFreader(const std::string & filename_, int threads_ = 1,
+            const std::vector<std::string> & regions_ = std::vector<std::string>(),
+            bool useMmap = false, threadPool * pool_ = NULL, uint64_t limit_ = UINT64_MAX)
+    : filename(filename_), type(compressionType(filename_)), threads(threads_), pool(pool_), limit(limit_), regions(regions_), mpos(NULL), mdata(NULL), mend(NULL),
+      lr(0), lc(0), lleft(0), rangeFirst(0), rangeLines(SIZE_MAX), left(SIZE_MAX), prof(NULL) {
+    if(type == 0)
+      throw std::runtime_error("Couldn't open file\n");
+    if(useMmap && type == 1) {
+      map.reset(new mmapFile(filename));
+      mpos = map->begin();
+      mend = map->begin() + std::min((uint64_t) map->size(), limit);
+    } else {
+      in.reset(new lineReader(filename, threads, pool, limit));
+      if(!in->good())
+        throw std::runtime_error("Couldn't open file\n");
+    }
+    // first skip header
+    const char * b;
+    const char * e;
+    std::string line;
+    while(nextLine(b, e)) {
+      if(e - b < 2 || b[0] != '#' || b[1] != '#') {
+        line.assign(b, e);
+        break;
+      }
+      header.push_back(std::string(b, e));
+    }
+    mdata = mpos;
+    // on doit être sur la ligne qui contient les samples
+    readVCFsamples(line, samples);
+
+    if(!regions.empty()) {
+      if(type == 1) {
+        bool stale;
+        std::string error;
+        lindex = openVCFindex(filename, stale, &error);
+        if(stale && !error.empty()) {
+          if(error.back() == '\n') error.pop_back();
+          throw std::runtime_error("The index of " + filename + " can't be used (" + error + "), cf buildVCFindex\n");
+        }
+        if(stale)
+          throw std::runtime_error("The index of " + filename + " is out of date (cf buildVCFindex)\n");
+        if(!lindex)
+          throw std::runtime_error("Region queries need a bgzip compressed file with a tabix index, "
+                                   "or an uncompressed file with an index (cf buildVCFindex)\n");
+        // un nom de contig connu de l'index est tout le contig (cf regionReader)
+        for(const std::string & s : regions)
+          lregions.push_back(lindex->refId(s) >= 0 ? wholeContig(s) : parseRegion(s));
+        lchunks = lindex->query(lregions[0]);
+      } else {
+        if(!in->isBGZF())
+          throw std::runtime_error("Region queries need a bgzip compressed file\n");
+        index.reset(new tabixIndex(filename));
+        rr.reset(new regionReader(in->bgzfStream(), *index, regions));
+      }
+    }
+  }
+
+  // les lignes de données sont-elles dans [dataBegin(), dataEnd()) ?
+  bool mapped() const {
+    return map && regions.empty();
+  }
+
+  // les lignes de données d'un fichier projeté en mémoire
+  const char * dataBegin() const {
+    return mdata;
+  }
+
+  const char * dataEnd() const {
+    return mend;
+  }
+
+  // la ligne suivante [b, e), sans le '\n' final, sans copie :
+  // valide jusqu'à l'appel suivant
+  bool nextLine(const char * & b, const char * & e) {
+    if(prof == NULL) return readLine(b, e);
+    uint64_t t0 = nowNs();
+    bool r = readLine(b, e);
+    prof->readNs += nowNs() - t0;
+    return r;
+  }
+
+  // le temps passé dans nextLine est ajouté à p->readNs (NULL : plus de mesure) ;
+  // les lignes d'un fichier projeté lues par parallelLines ne passent pas par nextLine
+  void profile(profileCounters * p) {
+    prof = p;
+  }
+
+  // reprend la lecture des données à offset octets du début du fichier, qui doit
+  // être un début de ligne (pour un fichier bgzip, le début d'un bloc) : pour ne
+  // lire que les lignes ajoutées à un fichier (cf la mise à jour du cache dans
+  // readVCFgenotypes). À ne pas combiner avec countLines
+  void seekData(uint64_t offset) {
+    if(!regions.empty())
+      throw std::runtime_error("Can't seek with region queries\n");
+    if(map && offset < (uint64_t) (mdata - map->begin()))
+      throw std::runtime_error("File seek error\n");
+    seekTo(offset);
+    mdata = mpos;
+  }
+
+  // ne donne que les lignes de données first, ..., first + n - 1 (à partir de 0 ;
+  // moins s'il n'y en a pas assez). Avec un index (cf VCFindex.h), la lecture
+  // commence au bloc qui contient first, sinon les lignes d'avant sont lues.
+  // À appeler avant de lire les données ; pas avec des régions ni seekData
+  void lineRange(size_t first, size_t n) {
+    if(!regions.empty())
+      throw std::runtime_error("Can't combine regions with a range of variants\n");
+    size_t skip = first;
+    if(type == 1) {
+      bool stale;
+      std::unique_ptr<VCFindex> idx = openVCFindex(filename, stale);
+      if(idx && idx->nblocks > 0 && first > 0) {
+        const VCFindexBlock & B = idx->blockOf(first);
+        seekTo(B.offset);
+        skip = first - B.line;
+      }
+    }
+    rangeFirst = first;
+    rangeLines = n;
+    if(map) {
+      mdata = mpos = skipLines(mpos, mend, skip);
+      mend = skipLines(mpos, mend, n);
+      return;
+    }
+    const char * b;
+    const char * e;
+    while(skip > 0 && in->nextLine(b, e)) skip--;
+    left = n;
+  }
+
+  bool getline(std::string & line) {
+    const char * b;
+    const char * e;
+    if(!nextLine(b, e)) return false;
+    line.assign(b, e);
+    return true;
+  }
+
+  // nombre de lignes de données, d'après l'index quand c'est possible,
+  // sinon par une première lecture du fichier (avec un second lecteur)
+  size_t countLines() {
+    if(!regions.empty()) {
+      VCFreader pre(filename, threads, regions, (bool) map, pool, limit);
+      size_t n = 0;
+      const char * b;
+      const char * e;
+      while(pre.nextLine(b, e)) n++;
+      return n;
+    }
+    size_t n;
+    if(map) {
+      if(rangeFirst == 0 && rangeLines == SIZE_MAX && indexedLines(n)) return n;
+      n = countNewlines(mdata, mend);
+      if(mdata < mend && mend[-1] != '\n') n++;
+      return n;
+    }
+    n = allLines();
+    n = n > rangeFirst ? n - rangeFirst : 0;
+    return std::min(n, rangeLines);
+  }
+
+  // le fichier a-t-il un index : tabix pour un fichier bgzip, celui de
+  // buildVCFindex (à jour) pour un fichier non compressé ?
+  bool indexed() const {
+    if(type == 3) return !tabixIndex::indexFile(filename).empty();
+    bool stale;
+    return type == 1 && openVCFindex(filename, stale) != NULL;
+  }
+
+  private:
+  // le nombre de lignes de données d'après l'index, s'il le donne
+  bool indexedLines(size_t & n) const {
+    if(limit != UINT64_MAX) return false; // l'index est celui de tout le fichier
+    if(type == 3 && !tabixIndex::indexFile(filename).empty()) {
+      tabixIndex idx(filename);
+      bool complete = true;
+      for(size_t i = 0; i < idx.sequences().size(); i++)
+        complete = complete && idx.nLines(i) > 0;
+      n = idx.nLines();
+      return complete;
+    }
+    if(type == 1) {
+      bool stale;
+      std::unique_ptr<VCFindex> idx = openVCFindex(filename, stale);
+      if(idx) n = idx->nlines;
+      return (bool) idx;
+    }
+    return false;
+  }
+
+  // toutes les lignes de données (fichier non projeté, sans régions)
+  size_t allLines() {
+    size_t n;
+    if(indexedLines(n)) return n;
+    VCFreader pre(filename, threads, std::vector<std::string>(), false, pool, limit);
+    return pre.in->countLines();
+  }
+};
+
+// les lignes de données de in, cf parallelLines
+// (lues directement dans la projection si le fichier est projeté en mémoire)
+template<typename W, typename M, typename C, typename F>
+size_t parallelLines(VCFreader & in, threadPool * pool, size_t chunkSize, W work, M merge, C check, F flush) {
+  if(in.mapped())
+    return parallelLines(in.dataBegin(), in.dataEnd(), pool, chunkSize, work, merge, check, flush);
+  return parallelLines<VCFreader>(in, pool, chunkSize, work, merge, check, flush);
+}
+
+template<typename W, typename M, typename C>
+size_t parallelLines(VCFreader & in, threadPool * pool, size_t chunkSize, W work, M merge, C check) {
+  return parallelLines(in, pool, chunkSize, work, merge, check, [](int) {});
+}
+
+#endif
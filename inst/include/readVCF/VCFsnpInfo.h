@@ -1,18 +1,22 @@
+#include <string>
+
 #ifndef _VCFsnpInfo_
 #define _VCFsnpInfo_
 
 // #CHROM  POS     ID      REF     ALT     QUAL    FILTER  INFO    FORMAT
-template<typename chrT>
+// strT = std::string (une copie des champs), ou charSpan : une vue sur
+// la ligne, valable tant que le buffer de la ligne n'est pas modifié
+template<typename chrT, typename strT = std::string>
 class VCFsnpInfo {
   public:
   chrT chr;
   int pos;
-  std::string id;
-  std::string ref;
-  std::string alt;
-  std::string qual;
-  std::string filter;
-  std::string info;
+  strT id;
+  strT ref;
+  strT alt;
+  strT qual;
+  strT filter;
+  strT info;
 };
 
 #endif
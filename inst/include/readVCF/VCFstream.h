@@ -0,0 +1,84 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include "VCFreader.h"
+#include "VCFsnpInfo.h"
+#include "VCFlineGenotypes.h"
+#include "threadPool.h"
+#include "variantTable.h"
+
+#ifndef _VCFstream_
+#define _VCFstream_
+
+// lecture d'un VCF par blocs de variants : le lecteur (fichier, décompression,
+// position dans les régions) reste ouvert entre deux blocs
+class VCFstream {
+  private:
+
+  std::unique_ptr<threadPool> pool; // aussi celui de la décompression (avant in)
+  VCFreader in;
+  std::vector<formatCache> formats; // un par thread
+  stringArena lines; // les lignes du dernier bloc
+  size_t nread;
+  bool eof;
+
+  public:
+  VCFstream(const std::string & filename, int threads = 1,
+            const std::vector<std::string> & regions = std::vector<std::string>())
+    : pool(threads > 1 ? new threadPool(threads) : NULL), in(filename, threads, regions, true, pool.get()),
+      formats(std::max(threads, 1)), nread(0), eof(false) {}
+
+  const std::vector<std::string> & samples() const {
+    return in.samples;
+  }
+
+  const std::vector<std::string> & header() const {
+    return in.header;
+  }
+
+  // nombre de variants déjà lus
+  size_t position() const {
+    return nread;
+  }
+
+  // lit au plus n variants ; les génotypes sont écrits dans dest, une matrice
+  // column-major de nlines x samples().size() qu'alloue alloc(nlines).
+  // Avec des charSpan dans snps, les champs sont des vues sur les lignes du
+  // bloc, valables jusqu'à l'appel suivant.
+  // Renvoie le nombre de variants lus (0 en fin de fichier)
+  template<typename chrT, typename strT, typename scalar, typename A>
+  size_t nextBlock(size_t n, std::vector< VCFsnpInfo<chrT, strT> > & snps, A alloc) {
+    lines.clear();
+    const char * b;
+    const char * e;
+    while(!eof && lines.size() < n) {
+      if(!in.nextLine(b, e)) {
+        eof = true;
+        break;
+      }
+      lines.push_back(charSpan(b, e));
+    }
+    size_t nl = lines.size();
+    snps.resize(nl);
+    scalar * dest = alloc(nl);
+    size_t ns = in.samples.size();
+
+    int nt = pool ? pool->size() : 1;
+    auto decode = [&, nl, ns, nt](int t) {
+      for(size_t i = nl * t / nt; i < nl * (t + 1) / nt; i++)
+        VCFlineGenotypes(lines[i].begin, lines[i].end, snps[i], dest + i, nl, ns, formats[t]);
+    };
+    if(!pool || nl < (size_t) nt) {
+      for(int t = 0; t < nt; t++) decode(t);
+    } else {
+      std::vector< std::future<void> > jobs;
+      for(int t = 0; t < nt; t++) jobs.push_back(pool->push([&decode, t] { decode(t); }));
+      waitJobs(jobs);
+    }
+    nread += nl;
+    return nl;
+  }
+};
+
+#endif
@@ -1,3 +1,5 @@
+#include <string_view>
+
 #ifndef VCFstring2geno
 #define VCFstring2geno
 
@@ -18,9 +20,10 @@ inline scalar VCFstringToGeno(const char * s, int le) {
   return g;
 }
 
+// (une std::string se convertit implicitement en std::string_view, sans copie)
 template<typename scalar>
-inline scalar VCFstringToGeno(std::string str) {
-  return VCFstringToGeno<scalar>(str.c_str(), str.length());
+inline scalar VCFstringToGeno(std::string_view str) {
+  return VCFstringToGeno<scalar>(str.data(), str.size());
 }
 
 #endif
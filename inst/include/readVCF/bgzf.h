@@ -0,0 +1,347 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <future>
+#include <algorithm>
+#include <zlib.h>
+#include "threadPool.h"
+#include "countNewlines.h"
+
+#ifndef _BGZF_
+#define _BGZF_
+
+// BGZF = suite de membres gzip de moins de 64 kB, dont le champ extra 'BC'
+// donne la taille du bloc compressé. Les blocs peuvent donc être lus sans
+// être décompressés, puis décompressés indépendamment les uns des autres.
+// Une position dans le fichier est un "virtual offset" :
+// (offset du bloc compressé << 16) | offset dans le bloc décompressé
+
+// fseek sur des fichiers de plus de 2 Go
+inline int fseek64(FILE * f, uint64_t offset) {
+#ifdef _WIN32
+  return _fseeki64(f, offset, SEEK_SET);
+#else
+  return fseeko(f, offset, SEEK_SET);
+#endif
+}
+
+// la tête d'un bloc BGZF : 18 octets
+inline bool isBGZFheader(const unsigned char * h) {
+  return h[0] == 31 && h[1] == 139 && h[2] == 8 && (h[3] & 4) != 0
+      && h[10] == 6 && h[11] == 0 && h[12] == 'B' && h[13] == 'C'
+      && h[14] == 2 && h[15] == 0;
+}
+
+// 0 = erreur d'ouverture, 1 = fichier texte, 2 = gzip, 3 = bgzf
+inline int compressionType(const std::string & filename) {
+  FILE * f = fopen(filename.c_str(), "rb");
+  if(f == NULL) return 0;
+  unsigned char h[18];
+  size_t n = fread(h, 1, 18, f);
+  fclose(f);
+  if(n >= 2 && h[0] == 31 && h[1] == 139) {
+    if(n == 18 && isBGZFheader(h)) return 3;
+    return 2;
+  }
+  return 1;
+}
+
+// lit un bloc compressé complet (tête comprise) dans cdata
+// renvoie false en fin de fichier, ou si le bloc fait plus de maxSize octets
+// (il n'est alors pas lu en entier)
+inline bool readBGZFblock(FILE * f, std::string & cdata, uint64_t maxSize = UINT64_MAX) {
+  unsigned char h[18];
+  if(maxSize < 18) return false;
+  size_t n = fread(h, 1, 18, f);
+  if(n == 0) return false;
+  if(n != 18 || !isBGZFheader(h))
+    throw std::runtime_error("Malformed BGZF block");
+  size_t bsize = (h[16] | (h[17] << 8)) + 1;
+  if(bsize < 26)
+    throw std::runtime_error("Malformed BGZF block");
+  if(bsize > maxSize) return false;
+  cdata.resize(bsize);
+  memcpy(&cdata[0], h, 18);
+  if(fread(&cdata[18], 1, bsize - 18, f) != bsize - 18)
+    throw std::runtime_error("Truncated BGZF block");
+  return true;
+}
+
+// décompresse un bloc lu par readBGZFblock
+inline void inflateBGZFblock(const std::string & cdata, std::string & data) {
+  const unsigned char * c = (const unsigned char *) cdata.data();
+  size_t bsize = cdata.size();
+  uint32_t crc   = c[bsize-8] | (c[bsize-7] << 8) | (c[bsize-6] << 16) | ((uint32_t) c[bsize-5] << 24);
+  uint32_t isize = c[bsize-4] | (c[bsize-3] << 8) | (c[bsize-2] << 16) | ((uint32_t) c[bsize-1] << 24);
+  data.resize(isize);
+  if(isize == 0) return; // bloc vide (marqueur de fin de fichier)
+
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  if(inflateInit2(&zs, -15) != Z_OK) // -15 = raw deflate
+    throw std::runtime_error("zlib initialization error");
+  zs.next_in = (Bytef *) (c + 18);
+  zs.avail_in = bsize - 26;
+  zs.next_out = (Bytef *) &data[0];
+  zs.avail_out = isize;
+  int ret = inflate(&zs, Z_FINISH);
+  inflateEnd(&zs);
+  if(ret != Z_STREAM_END || zs.total_out != isize)
+    throw std::runtime_error("BGZF block decompression error");
+  if(crc32(crc32(0L, Z_NULL, 0), (const Bytef *) data.data(), isize) != crc)
+    throw std::runtime_error("BGZF block CRC error");
+}
+
+// décompresse un fichier BGZF entier (pour les index)
+inline std::string readBGZFfile(const std::string & filename) {
+  FILE * f = fopen(filename.c_str(), "rb");
+  if(f == NULL)
+    throw std::runtime_error("Couldn't open file " + filename);
+  std::string res, cdata, data;
+  try {
+    while(readBGZFblock(f, cdata)) {
+      inflateBGZFblock(cdata, data);
+      res += data;
+    }
+  } catch(...) {
+    fclose(f);
+    throw;
+  }
+  fclose(f);
+  return res;
+}
+
+// lecteur de fichier BGZF ligne par ligne.
+// Les blocs sont lus par paquets de batchSize ; avec threads > 1 chaque paquet
+// est décompressé par un pool de threads pendant que le précédent est consommé.
+// Le pool peut être celui de l'appelant (shared, cf parallelLines) : les
+// décompressions passent alors entre les traitements de lignes, sur les mêmes
+// threads. nextLine doit être appelé hors de ce pool (il attend ses tâches)
+// limit : seuls les blocs compressés entiers avant l'octet limit sont lus
+// (un fichier qui grandit pendant la lecture)
+class bgzfReader {
+  private:
+
+  struct block {
+    uint64_t coffset; // offset du bloc compressé dans le fichier
+    std::string cdata;
+    std::string data;
+  };
+
+  struct batch {
+    std::vector<block> blocks;
+    uint64_t end; // offset du bloc compressé suivant
+    std::vector< std::future<void> > jobs;
+  };
+
+  FILE * f;
+  uint64_t fpos;
+  std::unique_ptr<threadPool> ownPool;
+  threadPool * pool; // ownPool, shared ou NULL
+  uint64_t limit;
+  bool stopped; // cf readBatch
+  size_t batchSize;
+  batch current, next;
+  bool nextPending;
+  size_t cur; // bloc courant dans current
+  size_t pos; // position dans le bloc courant
+  std::string spill; // une ligne à cheval sur plusieurs blocs, cf nextLine
+
+  // lit les blocs compressés d'un paquet et lance leur décompression
+  void readBatch(batch & b) {
+    b.blocks.clear();
+    b.jobs.clear();
+    block bl;
+    while(b.blocks.size() < batchSize && fpos < limit && !stopped) {
+      bl.coffset = fpos;
+      if(!readBGZFblock(f, bl.cdata, limit - fpos)) {
+        // fin du fichier, ou bloc qui dépasse limit : f n'est plus à fpos
+        stopped = true;
+        break;
+      }
+      fpos += bl.cdata.size();
+      b.blocks.push_back(std::move(bl));
+    }
+    b.end = fpos;
+    if(!pool) {
+      for(block & x : b.blocks) inflateBGZFblock(x.cdata, x.data);
+      return;
+    }
+    size_t nt = pool->size();
+    for(size_t t = 0; t < nt && t < b.blocks.size(); t++) {
+      std::vector<block> * bls = &b.blocks;
+      b.jobs.push_back(pool->push([bls, t, nt] {
+        for(size_t i = t; i < bls->size(); i += nt)
+          inflateBGZFblock((*bls)[i].cdata, (*bls)[i].data);
+      }));
+    }
+  }
+
+  // attend toutes les tâches avant de propager une éventuelle erreur
+  void waitBatch(batch & b) {
+    for(std::future<void> & j : b.jobs) j.wait();
+    std::vector< std::future<void> > jobs;
+    jobs.swap(b.jobs);
+    for(std::future<void> & j : jobs) j.get();
+  }
+
+  // attend les décompressions en cours, sans propager les erreurs
+  void cancelPending() {
+    if(nextPending) {
+      for(std::future<void> & j : next.jobs) j.wait();
+      next.jobs.clear();
+      nextPending = false;
+    }
+  }
+
+  // passe au paquet suivant ; renvoie false en fin de fichier
+  bool fill() {
+    if(nextPending) {
+      waitBatch(next);
+      std::swap(current, next);
+      nextPending = false;
+    } else {
+      readBatch(current);
+      waitBatch(current);
+    }
+    cur = 0;
+    pos = 0;
+    if(current.blocks.empty()) return false;
+    if(pool) {
+      readBatch(next);
+      nextPending = !next.blocks.empty();
+    }
+    return true;
+  }
+
+  public:
+  bgzfReader(const std::string & filename, int threads = 1, size_t batchSize_ = 64, threadPool * shared = NULL,
+             uint64_t limit_ = UINT64_MAX)
+    : fpos(0), pool(shared), limit(limit_), stopped(false), batchSize(batchSize_), nextPending(false), cur(0), pos(0) {
+    f = fopen(filename.c_str(), "rb");
+    if(f == NULL)
+      throw std::runtime_error("Couldn't open file " + filename);
+    if(pool == NULL && threads > 1) {
+      ownPool.reset(new threadPool(threads));
+      pool = ownPool.get();
+    }
+    if(pool != NULL) batchSize *= pool->size();
+    current.end = 0;
+  }
+
+  ~bgzfReader() {
+    cancelPending();
+    fclose(f);
+  }
+
+  bgzfReader(const bgzfReader &) = delete;
+  bgzfReader & operator=(const bgzfReader &) = delete;
+
+  // la ligne suivante [b, e), sans le '\n' final : directement dans le bloc
+  // décompressé quand elle y tient, sinon recopiée ; valide jusqu'à l'appel suivant
+  bool nextLine(const char * & b, const char * & e) {
+    if(cur < current.blocks.size()) {
+      const std::string & d = current.blocks[cur].data;
+      const char * s = d.data() + pos;
+      const char * nl = (const char *) memchr(s, '\n', d.size() - pos);
+      if(nl != NULL) {
+        b = s;
+        e = nl;
+        pos += (nl - s) + 1;
+        if(pos == d.size()) {
+          cur++;
+          pos = 0;
+        }
+        return true;
+      }
+    }
+    if(!getline(spill)) return false;
+    b = spill.data();
+    e = b + spill.size();
+    return true;
+  }
+
+  // lit une ligne, sans le '\n' final
+  bool getline(std::string & line) {
+    line.clear();
+    bool any = false;
+    while(true) {
+      if(cur == current.blocks.size()) {
+        if(!fill()) return any;
+      }
+      const std::string & d = current.blocks[cur].data;
+      const char * s = d.data() + pos;
+      size_t n = d.size() - pos;
+      const char * nl = (const char *) memchr(s, '\n', n);
+      if(nl != NULL) {
+        line.append(s, nl - s);
+        pos += (nl - s) + 1;
+        if(pos == d.size()) {
+          cur++;
+          pos = 0;
+        }
+        return true;
+      }
+      line.append(s, n);
+      any = any || n > 0;
+      cur++;
+      pos = 0;
+    }
+  }
+
+  // compte les lignes restantes (consomme le flux)
+  size_t countLines() {
+    size_t n = 0;
+    char last = '\n';
+    while(true) {
+      if(cur == current.blocks.size()) {
+        if(!fill()) break;
+      }
+      const std::string & d = current.blocks[cur].data;
+      if(pos < d.size()) {
+        n += countNewlines(d.data() + pos, d.data() + d.size());
+        last = d.back();
+      }
+      cur++;
+      pos = 0;
+    }
+    if(last != '\n') n++;
+    return n;
+  }
+
+  // virtual offset de la position courante
+  uint64_t tell() const {
+    if(cur < current.blocks.size())
+      return (current.blocks[cur].coffset << 16) | pos;
+    return current.end << 16;
+  }
+
+  // se positionne sur un virtual offset
+  void seek(uint64_t voffset) {
+    cancelPending();
+    fpos = voffset >> 16;
+    stopped = false;
+    if(fseek64(f, fpos) != 0)
+      throw std::runtime_error("BGZF seek error");
+    current.blocks.clear();
+    current.end = fpos;
+    cur = 0;
+    pos = 0;
+    size_t upos = voffset & 0xFFFF;
+    if(upos > 0) {
+      if(!fill() || upos > current.blocks[0].data.size())
+        throw std::runtime_error("BGZF seek error");
+      pos = upos;
+      if(pos == current.blocks[0].data.size()) {
+        cur++;
+        pos = 0;
+      }
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,178 @@
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <cstdint>
+
+#ifndef _CONSTSTRINGSTREAMLITE_
+#define _CONSTSTRINGSTREAMLITE_
+
+// un morceau [begin, end) d'un buffer, sans copie
+struct charSpan {
+  const char * begin;
+  const char * end;
+
+  charSpan() : begin(NULL), end(NULL) {}
+  charSpan(const char * b, const char * e) : begin(b), end(e) {}
+
+  size_t size() const {
+    return end - begin;
+  }
+
+  bool empty() const {
+    return begin == end;
+  }
+
+  std::string str() const {
+    return std::string(begin, end);
+  }
+
+  bool operator==(const char * s) const {
+    size_t n = strlen(s);
+    return n == size() && memcmp(begin, s, n) == 0;
+  }
+};
+
+// entier en base 10, sans lire au delà de end ; NA_integer_ si vide
+inline int spanToInt(const char * b, const char * e) {
+  if(b == e) return -2147483648; // R NA_integer_
+  bool neg = false;
+  if(*b == '-' || *b == '+') {
+    neg = (*b == '-');
+    b++;
+  }
+  long x = 0;
+  for(; b < e && *b >= '0' && *b <= '9'; b++) x = 10*x + (*b - '0');
+  return neg ? -x : x;
+}
+
+// nombre décimal [b, e), sans allocation ni locale ; NAN si vide ou "."
+// jusqu'à 15 chiffres significatifs et un exposant décimal d'au plus 22,
+// le résultat est exact (un seul arrondi) ; sinon on passe par strtod
+inline double spanToDouble(const char * b, const char * e) {
+  static const double p10[23] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  const char * s = b;
+  bool neg = false;
+  if(b < e && (*b == '-' || *b == '+')) {
+    neg = (*b == '-');
+    b++;
+  }
+  uint64_t m = 0;
+  int nd = 0, ex = 0;
+  bool digits = false;
+  for(; b < e && *b >= '0' && *b <= '9'; b++) {
+    digits = true;
+    if(nd < 19) {
+      m = 10*m + (*b - '0');
+      if(m) nd++;
+    } else {
+      ex++;
+    }
+  }
+  if(b < e && *b == '.') {
+    for(b++; b < e && *b >= '0' && *b <= '9'; b++) {
+      digits = true;
+      if(nd < 19) {
+        m = 10*m + (*b - '0');
+        if(m) nd++;
+        ex--;
+      }
+    }
+  }
+  if(!digits) {
+    if(b == e) return NAN; // "" ou "."
+    std::string t(s, e);
+    return strtod(t.c_str(), NULL); // nan, inf...
+  }
+  if(b < e && (*b == 'e' || *b == 'E')) {
+    const char * p = b + 1;
+    bool eneg = false;
+    if(p < e && (*p == '-' || *p == '+')) {
+      eneg = (*p == '-');
+      p++;
+    }
+    int x = 0;
+    for(; p < e && *p >= '0' && *p <= '9'; p++)
+      if(x < 10000) x = 10*x + (*p - '0');
+    ex += eneg ? -x : x;
+    b = p;
+  }
+  if(b != e || nd > 15 || ex < -22 || ex > 22) {
+    std::string t(s, e);
+    return strtod(t.c_str(), NULL);
+  }
+  double x = (double) m;
+  x = ex < 0 ? x / p10[-ex] : x * p10[ex];
+  return neg ? -x : x;
+}
+
+// comme stringStreamLite, mais la chaîne n'est pas modifiée (pas de 0 inséré) :
+// utilisable sur un buffer en lecture seule (fichier mappé en mémoire),
+// et sans 0 final, les tokens sont des charSpan
+class constStringStreamLite {
+  private:
+
+  const char * debut;
+  const char * fin;
+  char delim;
+  charSpan token;
+  bool eof;
+
+  public:
+  constStringStreamLite(const char * debut_, const char * fin_, char delim_)
+    : debut(debut_), fin(fin_), delim(delim_), eof(debut_ == fin_) {}
+
+  // renvoie la longueur du token, positionne debut au début du token suivant
+  size_t next_token() {
+    if(debut == fin) {
+      token = charSpan(debut, debut);
+      eof = true;
+      return 0;
+    }
+    const char * d = (const char *) memchr(debut, delim, fin - debut);
+    if(d == NULL) {
+      token = charSpan(debut, fin);
+      debut = fin;
+    } else {
+      token = charSpan(debut, d);
+      debut = d + 1;
+    }
+    return token.size();
+  }
+
+  // ce qui reste à lire
+  charSpan rest() const {
+    return charSpan(debut, fin);
+  }
+
+  constStringStreamLite & operator>>(charSpan & s) {
+    next_token();
+    s = token;
+    return *this;
+  }
+
+  constStringStreamLite & operator>>(std::string & s) {
+    next_token();
+    s.assign(token.begin, token.end);
+    return *this;
+  }
+
+  constStringStreamLite & operator>>(int & x) {
+    next_token();
+    x = spanToInt(token.begin, token.end);
+    return *this;
+  }
+
+  constStringStreamLite & operator>>(double & x) {
+    next_token();
+    x = spanToDouble(token.begin, token.end);
+    return *this;
+  }
+
+  operator bool() {
+    return !eof;
+  }
+};
+
+#endif
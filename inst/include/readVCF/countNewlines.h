@@ -0,0 +1,51 @@
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#ifndef _countNewlines_
+#define _countNewlines_
+
+// nombre de '\n' dans [b, e), 16 octets à la fois quand c'est possible :
+// les comparaisons sont accumulées dans 16 compteurs d'un octet,
+// additionnés au plus tous les 255 blocs
+inline size_t countNewlines(const char * b, const char * e) {
+  size_t n = 0;
+#if defined(__SSE2__)
+  const __m128i nl = _mm_set1_epi8('\n');
+  while(e - b >= 16) {
+    __m128i acc = _mm_setzero_si128();
+    size_t blocks = std::min((size_t) 255, (size_t) (e - b) / 16);
+    for(size_t k = 0; k < blocks; k++, b += 16)
+      acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) b), nl));
+    __m128i s = _mm_sad_epu8(acc, _mm_setzero_si128());
+    n += _mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const uint8x16_t nl = vdupq_n_u8('\n');
+  while(e - b >= 16) {
+    uint8x16_t acc = vdupq_n_u8(0);
+    size_t blocks = std::min((size_t) 255, (size_t) (e - b) / 16);
+    for(size_t k = 0; k < blocks; k++, b += 16)
+      acc = vsubq_u8(acc, vceqq_u8(vld1q_u8((const uint8_t *) b), nl));
+    n += vaddlvq_u8(acc);
+  }
+#endif
+  return n + std::count(b, e, '\n');
+}
+
+// la position après n lignes à partir de b (e s'il y en a moins)
+inline const char * skipLines(const char * b, const char * e, size_t n) {
+  for(; n > 0 && b < e; n--) {
+    const char * nl = (const char *) memchr(b, '\n', e - b);
+    b = (nl == NULL) ? e : nl + 1;
+  }
+  return b;
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include <string>
+#include <vector>
+#include <cstring>
+#include "constStringStreamLite.h"
+
+#ifndef _formatCache_
+#define _formatCache_
+
+// la disposition des sous-champs d'un FORMAT ("GT:AD:DP:GQ:PL" etc)
+// les positions valent -1 quand le champ est absent
+struct formatLayout {
+  std::string format;
+  std::vector<std::string> fields;
+  int GT, DS, GP, GQ, DP;
+  bool gtOnly; // FORMAT == "GT"
+
+  explicit formatLayout(const charSpan & f) : format(f.begin, f.end) {
+    constStringStreamLite ss(f.begin, f.end, ':');
+    std::string tok;
+    while(ss >> tok) fields.push_back(tok);
+    GT = position("GT");
+    DS = position("DS");
+    GP = position("GP");
+    GQ = position("GQ");
+    DP = position("DP");
+    gtOnly = (format == "GT");
+  }
+
+  int position(const char * key) const {
+    for(size_t i = 0; i < fields.size(); i++)
+      if(fields[i] == key) return i;
+    return -1;
+  }
+};
+
+// la position du champ field dans le FORMAT (GT, DS, GP, GQ et DP sont
+// déjà dans le cache)
+inline int fieldPosition(const formatLayout & layout, const std::string & field) {
+  if(field == "GT") return layout.GT;
+  if(field == "DS") return layout.DS;
+  if(field == "GP") return layout.GP;
+  if(field == "GQ") return layout.GQ;
+  if(field == "DP") return layout.DP;
+  return layout.position(field.c_str());
+}
+
+// les FORMAT déjà rencontrés : un fichier n'en a en général qu'un ou deux,
+// la plupart des lignes se résolvent par une comparaison avec le dernier.
+// Au plus maxLayouts FORMAT sont gardés : au-delà (un fichier où ils varient
+// d'une ligne à l'autre), le plus ancien est remplacé ; la mémoire et la
+// recherche restent bornées. Le layout renvoyé par get n'est valide que
+// jusqu'à l'appel suivant.
+// Un cache par lecteur (par thread : pas de synchronisation)
+class formatCache {
+  private:
+
+  static const size_t maxLayouts = 32;
+  std::vector<formatLayout> layouts;
+  size_t last;
+  size_t oldest; // le prochain remplacé, quand le cache est plein
+
+  static bool same(const formatLayout & L, const charSpan & f) {
+    return L.format.size() == f.size() && memcmp(L.format.data(), f.begin, f.size()) == 0;
+  }
+
+  public:
+  formatCache() : last(0), oldest(0) {}
+
+  const formatLayout & get(const charSpan & f) {
+    if(last < layouts.size() && same(layouts[last], f))
+      return layouts[last];
+    for(size_t i = 0; i < layouts.size(); i++) {
+      if(same(layouts[i], f)) {
+        last = i;
+        return layouts[i];
+      }
+    }
+    if(layouts.size() < maxLayouts) {
+      layouts.push_back(formatLayout(f));
+      last = layouts.size() - 1;
+    } else {
+      layouts[oldest] = formatLayout(f);
+      last = oldest;
+      oldest = (oldest + 1) % maxLayouts;
+    }
+    return layouts[last];
+  }
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include <vector>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+#ifndef _genotypeCounts_
+#define _genotypeCounts_
+
+// un "sink" pour VCFlineGenotypes qui ne garde que les effectifs des
+// génotypes 0, 1, 2 et 3 (NA) : rien n'est stocké par sample
+struct genotypeCounts {
+  typedef int value_type;
+  size_t n[4];
+
+  genotypeCounts() {
+    clear();
+  }
+
+  void clear() {
+    n[0] = n[1] = n[2] = n[3] = 0;
+  }
+
+  void push_back(int g) {
+    n[g & 3]++;
+  }
+
+  size_t called() const {
+    return n[0] + n[1] + n[2];
+  }
+
+  size_t total() const {
+    return called() + n[3];
+  }
+
+  // fréquence de l'allèle alternatif
+  double AF() const {
+    return called() == 0 ? NAN : (n[1] + 2.0 * n[2]) / (2.0 * called());
+  }
+
+  double missingRate() const {
+    return total() == 0 ? NAN : (double) n[3] / total();
+  }
+
+  double heterozygosity() const {
+    return called() == 0 ? NAN : (double) n[1] / called();
+  }
+};
+
+// test exact de Hardy-Weinberg (Wigginton, Cutler & Abecasis 2005)
+// buf : un buffer de travail, réutilisé d'un appel à l'autre
+inline double HWEexact(size_t n0, size_t nhet, size_t n2, std::vector<double> & buf) {
+  long homr = std::min(n0, n2), homc = std::max(n0, n2), het = nhet;
+  long rare = 2 * homr + het;
+  long N = het + homr + homc;
+  if(N == 0) return NAN;
+
+  buf.assign(rare + 1, 0.0);
+  long mid = rare * (2 * N - rare) / (2 * N);
+  if((rare & 1) != (mid & 1)) mid++;
+
+  buf[mid] = 1.0;
+  double sum = 1.0;
+  long h = mid, r = (rare - mid) / 2, c = N - mid - r;
+  for(; h > 1; h -= 2, r++, c++) {
+    buf[h - 2] = buf[h] * h * (h - 1.0) / (4.0 * (r + 1.0) * (c + 1.0));
+    sum += buf[h - 2];
+  }
+  h = mid; r = (rare - mid) / 2; c = N - mid - r;
+  for(; h <= rare - 2; h += 2, r--, c--) {
+    buf[h + 2] = buf[h] * 4.0 * r * c / ((h + 2.0) * (h + 1.0));
+    sum += buf[h + 2];
+  }
+
+  double p = 0.0, obs = buf[het];
+  for(long i = 0; i <= rare; i++)
+    if(buf[i] <= obs) p += buf[i];
+  return std::min(1.0, p / sum);
+}
+
+#endif
@@ -0,0 +1,139 @@
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include "packedGenotypes.h"
+#include "VCFcache.h"
+
+#ifndef _lazyGenotypes_
+#define _lazyGenotypes_
+
+// Les génotypes sur 2 bits d'une matrice décodée à la demande (cf lazyGenotypes.cpp) :
+// les SNPs first, ..., first + nsnps - 1 du cache projeté en mémoire, ou d'un
+// packedGenotypes. La matrice est variants x samples (byVariants) ou
+// samples x variants, en column-major, avec les valeurs 0, 1, 2, 3 (NA)
+// de la matrice ordinaire.
+// Les effectifs des codes (cf counts) donnent la somme de la matrice sans la décoder.
+class lazyGenotypes {
+  private:
+
+  std::shared_ptr<const VCFcache> cache;
+  std::shared_ptr<const packedGenotypes> packed;
+  size_t first;
+  uint64_t totals[4]; // cf counts
+  bool counted;
+
+  // effectifs des 4 codes de chaque octet
+  struct byteCounts {
+    uint8_t n[256][4];
+    byteCounts() {
+      for(int c = 0; c < 256; c++) {
+        memset(n[c], 0, 4);
+        for(int k = 0; k < 4; k++) n[c][(c >> (2 * k)) & 3]++;
+      }
+    }
+  };
+
+  public:
+  size_t nsnps, nsamples;
+  bool byVariants;
+
+  lazyGenotypes(std::shared_ptr<const VCFcache> C, size_t first_, size_t n, bool byVariants_)
+    : cache(C), first(first_), counted(false), nsnps(n), nsamples(C->nsamples), byVariants(byVariants_) {}
+
+  lazyGenotypes(std::shared_ptr<const packedGenotypes> P, bool byVariants_)
+    : packed(P), first(0), counted(false), nsnps(P->nSNPs()), nsamples(P->nSamples()), byVariants(byVariants_) {}
+
+  size_t size() const {
+    return nsnps * nsamples;
+  }
+
+  const uint8_t * row(size_t snp) const {
+    return cache ? cache->row(first + snp) : packed->row(first + snp);
+  }
+
+  int get(size_t snp, size_t sample) const {
+    return (row(snp)[sample >> 2] >> ((sample & 3) << 1)) & 3;
+  }
+
+  // l'élément k de la matrice
+  int elt(size_t k) const {
+    if(byVariants) return get(k % nsnps, k / nsnps);
+    return get(k / nsamples, k % nsamples);
+  }
+
+  // les éléments k, ..., k + n - 1 dans buf
+  template<typename scalar>
+  void region(size_t k, size_t n, scalar * buf) const {
+    if(n == 0) return;
+    // l'élément k est (snp, sample) ; on avance le long d'une colonne
+    size_t a = byVariants ? k % nsnps : k % nsamples;   // position dans la colonne
+    size_t b = byVariants ? k / nsnps : k / nsamples;   // colonne
+    size_t len = byVariants ? nsnps : nsamples;
+    for(size_t i = 0; i < n; ) {
+      size_t m = std::min(n - i, len - a);
+      if(byVariants) {
+        // un sample, des variants consécutifs
+        size_t shift = (b & 3) << 1, byte = b >> 2;
+        for(size_t t = 0; t < m; t++) buf[i + t] = (row(a + t)[byte] >> shift) & 3;
+      } else {
+        // un variant, des samples consécutifs
+        const uint8_t * r = row(b);
+        for(size_t t = 0; t < m; t++) {
+          size_t j = a + t;
+          buf[i + t] = (r[j >> 2] >> ((j & 3) << 1)) & 3;
+        }
+      }
+      i += m;
+      a = 0;
+      b++;
+    }
+  }
+
+  // toute la matrice dans dest (size() valeurs)
+  template<typename scalar>
+  void decode(scalar * dest) const {
+    for(size_t i = 0; i < nsnps; i++) {
+      const uint8_t * r = row(i);
+      scalar * d = byVariants ? dest + i : dest + i * nsamples;
+      size_t stride = byVariants ? nsnps : 1;
+      for(size_t j = 0; j < nsamples; j++)
+        d[j * stride] = (r[j >> 2] >> ((j & 3) << 1)) & 3;
+    }
+  }
+
+  // effectifs des codes 0, 1, 2, 3 dans toute la matrice, comptés une fois
+  // pour toutes, octet par octet (les données ne changent pas)
+  void counts(uint64_t n[4]) {
+    if(!counted) {
+      static const byteCounts T;
+      size_t bytes = (nsamples + 3) / 4;
+      size_t padding = 4 * bytes - nsamples; // bits de remplissage à 0, comptés en code 0
+      totals[0] = totals[1] = totals[2] = totals[3] = 0;
+      for(size_t i = 0; i < nsnps; i++) {
+        const uint8_t * r = row(i);
+        uint32_t c[4] = {0, 0, 0, 0};
+        for(size_t k = 0; k < bytes; k++) {
+          const uint8_t * t = T.n[r[k]];
+          c[0] += t[0];
+          c[1] += t[1];
+          c[2] += t[2];
+          c[3] += t[3];
+        }
+        totals[0] += c[0] - padding;
+        for(int k = 1; k < 4; k++) totals[k] += c[k];
+      }
+      counted = true;
+    }
+    for(int k = 0; k < 4; k++) n[k] = totals[k];
+  }
+
+  // somme de tous les éléments
+  double sum() {
+    uint64_t n[4];
+    counts(n);
+    return (double) n[1] + 2.0 * n[2] + 3.0 * n[3];
+  }
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include <cstring>
+#include <string>
+#include "countNewlines.h"
+
+#ifndef _lineBuffer_
+#define _lineBuffer_
+
+// Découpage en lignes d'un flux lu par gros blocs (quelques Mo)
+// Blocks : tout objet avec bool next(const char * & b, size_t & n), qui donne
+// le bloc suivant [b, b + n), valable jusqu'à l'appel suivant, et false en fin
+// de fichier (cf readAhead). Les fins de lignes sont cherchées avec memchr ;
+// une ligne contenue dans un bloc est donnée directement dans le bloc, sans
+// copie, une ligne à cheval sur plusieurs blocs est recopiée dans spill.
+class lineBuffer {
+  private:
+
+  const char * p;   // données non consommées du bloc courant : [p, end)
+  const char * end;
+  std::string spill;
+
+  public:
+  lineBuffer() : p(NULL), end(NULL) {}
+
+  // la ligne suivante [lb, le), sans le '\n' final ; valide jusqu'à l'appel suivant
+  template<typename Blocks>
+  bool nextLine(Blocks & src, const char * & lb, const char * & le) {
+    if(p < end) {
+      const char * nl = (const char *) memchr(p, '\n', end - p);
+      if(nl != NULL) {
+        lb = p;
+        le = nl;
+        p = nl + 1;
+        return true;
+      }
+    }
+    // la fin du bloc est le début de la ligne, qui continue dans les blocs suivants
+    spill.assign(p, end);
+    p = end;
+    const char * b;
+    size_t n;
+    while(src.next(b, n)) {
+      const char * nl = (const char *) memchr(b, '\n', n);
+      p = b;
+      end = b + n;
+      if(nl != NULL) {
+        p = nl + 1;
+        if(spill.empty()) {
+          lb = b;
+          le = nl;
+          return true;
+        }
+        spill.append(b, nl);
+        lb = spill.data();
+        le = lb + spill.size();
+        return true;
+      }
+      spill.append(b, end);
+      p = end;
+    }
+    // fin du fichier : la dernière ligne, sans '\n'
+    if(spill.empty()) return false;
+    lb = spill.data();
+    le = lb + spill.size(); // spill est vidé à l'appel suivant
+    return true;
+  }
+
+  // nombre de lignes restant à lire (consomme le flux)
+  template<typename Blocks>
+  size_t countLines(Blocks & src) {
+    size_t n = 0;
+    char last = '\n';
+    if(p < end) {
+      n += countNewlines(p, end);
+      last = end[-1];
+    }
+    p = end;
+    const char * b;
+    size_t k;
+    while(src.next(b, k)) {
+      if(k == 0) continue;
+      n += countNewlines(b, b + k);
+      last = b[k - 1];
+    }
+    p = end = NULL;
+    if(last != '\n') n++;
+    return n;
+  }
+
+  // oublie les données lues (après un déplacement dans la source)
+  void clear() {
+    p = end = NULL;
+    spill.clear();
+  }
+};
+
+#endif
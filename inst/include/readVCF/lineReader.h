@@ -0,0 +1,167 @@
+#include <cstdio>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "bgzf.h"
+#include "lineBuffer.h"
+#include "readAhead.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+#ifndef _LINEREADER_
+#define _LINEREADER_
+
+// lecture ligne par ligne d'un fichier texte, gzip ou bgzip
+// le type de fichier est détecté d'après les premiers octets, pas d'après l'extension
+// Les fichiers texte et gzip sont lus par gros blocs (cf lineBuffer), par un
+// thread de lecture anticipée (cf readAhead : la lecture, et la décompression
+// d'un fichier gzip, se font pendant le traitement des lignes) ;
+// les fichiers bgzip bloc par bloc (cf bgzfReader)
+class lineReader {
+  private:
+
+  int type; // cf compressionType
+  FILE * f;
+  gzFile gz;
+  std::unique_ptr<bgzfReader> bgzf;
+  lineBuffer buffer; // pour les fichiers texte et gzip
+  uint64_t limit; // cf le constructeur
+
+  // les sources de readAhead
+  // fichier texte : rien n'est lu au-delà de l'octet end (pos : la position dans f)
+  struct fileSource {
+    FILE * f;
+    uint64_t pos, end;
+    size_t read(char * p, size_t n) {
+      if(pos >= end) return 0;
+      n = (size_t) std::min((uint64_t) n, end - pos);
+      size_t k = fread(p, 1, n, f);
+      pos += k;
+      if(k < n && ferror(f))
+        throw std::runtime_error("File read error");
+      return k;
+    }
+  };
+
+  struct gzSource {
+    gzFile gz;
+    size_t read(char * p, size_t n) {
+      int k = gzread(gz, p, (unsigned) std::min(n, (size_t) INT_MAX));
+      if(k < 0)
+        throw std::runtime_error("gzip decompression error");
+      return k;
+    }
+  };
+
+  std::unique_ptr< readAhead<fileSource> > fileAhead;
+  std::unique_ptr< readAhead<gzSource> > gzAhead;
+
+  public:
+  // threads = nombre de threads de décompression (fichiers bgzip seulement),
+  // ou ceux de shared, cf bgzfReader
+  // limit : la lecture s'arrête à l'octet limit du fichier (texte ou bgzip,
+  // cf bgzfReader ; pas pour gzip), même si le fichier grandit pendant la lecture
+  lineReader(const std::string & filename, int threads = 1, threadPool * shared = NULL,
+             uint64_t limit_ = UINT64_MAX) : f(NULL), gz(NULL), limit(limit_) {
+    type = compressionType(filename);
+    if(type == 1) {
+      f = fopen(filename.c_str(), "rb");
+      if(f != NULL) {
+#if defined(POSIX_FADV_SEQUENTIAL) && !defined(_WIN32)
+        posix_fadvise(fileno(f), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        fileAhead.reset(new readAhead<fileSource>(fileSource{f, 0, limit}));
+      }
+    } else if(type == 2) {
+      gz = gzopen(filename.c_str(), "rb");
+      if(gz != NULL) {
+        gzbuffer(gz, 1 << 18);
+        gzAhead.reset(new readAhead<gzSource>(gzSource{gz}));
+      }
+    } else if(type == 3) {
+      bgzf.reset(new bgzfReader(filename, threads, 64, shared, limit));
+    }
+  }
+
+  ~lineReader() {
+    // les threads de lecture d'abord
+    fileAhead.reset();
+    gzAhead.reset();
+    if(f != NULL) fclose(f);
+    if(gz != NULL) gzclose(gz);
+  }
+
+  lineReader(const lineReader &) = delete;
+  lineReader & operator=(const lineReader &) = delete;
+
+  bool good() const {
+    if(type == 1) return f != NULL;
+    if(type == 2) return gz != NULL;
+    return type == 3;
+  }
+
+  bool isBGZF() const {
+    return type == 3;
+  }
+
+  // pour les accès indexés
+  bgzfReader & bgzfStream() {
+    return *bgzf;
+  }
+
+  // la ligne suivante [b, e), sans le '\n' final, sans copie :
+  // valide jusqu'à l'appel suivant
+  bool nextLine(const char * & b, const char * & e) {
+    if(type == 1) return buffer.nextLine(*fileAhead, b, e);
+    if(type == 2) return buffer.nextLine(*gzAhead, b, e);
+    if(type == 3) return bgzf->nextLine(b, e);
+    return false;
+  }
+
+  // reprend la lecture à offset octets du début du fichier
+  // (pour un fichier bgzip, offset doit être le début d'un bloc)
+  void seek(uint64_t offset) {
+    if(type == 1) {
+      // offset au-delà de la fin : erreur sans toucher à la lecture en cours
+      struct stat st;
+      if(fstat(fileno(f), &st) != 0 || offset > (uint64_t) st.st_size)
+        throw std::runtime_error("File seek error");
+      // le thread de lecture lit f : il est arrêté avant fseek, et relancé
+      // ensuite même si fseek échoue (fileAhead n'est jamais laissé vide)
+      fileAhead.reset();
+      bool ok = fseek64(f, offset) == 0;
+      buffer.clear();
+      fileAhead.reset(new readAhead<fileSource>(fileSource{f, ok ? offset : limit, limit}));
+      if(!ok)
+        throw std::runtime_error("File seek error");
+    } else if(type == 3) {
+      bgzf->seek(offset << 16);
+    } else {
+      throw std::runtime_error("Can't seek in a gzip file");
+    }
+  }
+
+  bool getline(std::string & line) {
+    const char * b;
+    const char * e;
+    if(!nextLine(b, e)) return false;
+    line.assign(b, e);
+    return true;
+  }
+
+  // nombre de lignes restant à lire (consomme le flux)
+  size_t countLines() {
+    if(type == 1) return buffer.countLines(*fileAhead);
+    if(type == 2) return buffer.countLines(*gzAhead);
+    if(type == 3) return bgzf->countLines();
+    return 0;
+  }
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+#ifndef _lineTile_
+#define _lineTile_
+
+// Transposition par blocs : src a nlines lignes de ncols valeurs (la ligne l
+// commence en src + l * srcStride), écrites dans dest[l + j * destStride].
+// Les blocs de B x B valeurs tiennent dans le cache L1 ; chaque colonne du
+// bloc est écrite en B valeurs contiguës
+template<typename T>
+void transposeBlocks(const T * src, size_t nlines, size_t ncols, size_t srcStride, T * dest, size_t destStride) {
+  const size_t B = 32;
+  for(size_t j0 = 0; j0 < ncols; j0 += B) {
+    size_t j1 = std::min(j0 + B, ncols);
+    for(size_t l0 = 0; l0 < nlines; l0 += B) {
+      size_t l1 = std::min(l0 + B, nlines);
+      for(size_t j = j0; j < j1; j++) {
+        T * d = dest + j * destStride;
+        const T * s = src + j;
+        for(size_t l = l0; l < l1; l++) d[l] = s[l * srcStride];
+      }
+    }
+  }
+}
+
+// Les lignes décodées par un thread (nsamples valeurs contiguës par variant)
+// sont gardées par paquets de lignes consécutives, puis transposées ensemble
+// dans la matrice variants x samples (column-major, ld = nombre de lignes) :
+// au lieu d'écrire chaque génotype avec un pas de ld, on écrit des suites
+// contiguës de génotypes d'un même sample.
+// Une tuile par slot de parallelLines : next(row) donne la place de la ligne
+// row dans la tuile (après avoir vidé la tuile si row ne suit pas la ligne
+// précédente, ou si elle est pleine) ; flush à la fin de chaque sous-morceau
+template<typename T>
+class lineTile {
+  private:
+
+  size_t nsamples;
+  size_t lines; // capacité, en lignes
+  std::vector<T> buf;
+  size_t first; // numéro de la première ligne de la tuile
+  size_t n;
+
+  public:
+  // au plus 64 lignes, et au plus ~1 Mo (mais au moins 16 lignes)
+  explicit lineTile(size_t nsamples_) : nsamples(nsamples_), first(0), n(0) {
+    size_t l = (1 << 20) / (sizeof(T) * std::max(nsamples, (size_t) 1));
+    lines = std::max((size_t) 16, std::min((size_t) 64, l));
+  }
+
+  T * next(size_t row, T * dest, size_t ld) {
+    if(n > 0 && (row != first + n || n == lines)) flush(dest, ld);
+    if(buf.empty()) buf.resize(lines * nsamples);
+    if(n == 0) first = row;
+    return &buf[n++ * nsamples];
+  }
+
+  void flush(T * dest, size_t ld) {
+    if(n == 0) return;
+    transposeBlocks(buf.data(), n, nsamples, nsamples, dest + first, ld);
+    n = 0;
+  }
+};
+
+#endif
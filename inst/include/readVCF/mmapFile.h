@@ -0,0 +1,97 @@
+#include <string>
+#include <stdexcept>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifndef _MMAPFILE_
+#define _MMAPFILE_
+
+// un fichier projeté en mémoire, en lecture seule
+class mmapFile {
+  private:
+
+  const char * data;
+  size_t length;
+#ifdef _WIN32
+  HANDLE file, mapping;
+#endif
+
+  public:
+  explicit mmapFile(const std::string & filename) : data(NULL), length(0) {
+#ifdef _WIN32
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+      throw std::runtime_error("Couldn't open file " + filename);
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    length = size.QuadPart;
+    mapping = NULL;
+    if(length > 0) {
+      mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+      if(mapping == NULL) {
+        CloseHandle(file);
+        throw std::runtime_error("Couldn't map file " + filename);
+      }
+      data = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      if(data == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("Couldn't map file " + filename);
+      }
+    }
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+      throw std::runtime_error("Couldn't open file " + filename);
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+      close(fd);
+      throw std::runtime_error("Couldn't stat file " + filename);
+    }
+    length = st.st_size;
+    if(length > 0) {
+      void * p = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+      if(p == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Couldn't map file " + filename);
+      }
+      data = (const char *) p;
+      madvise(p, length, MADV_SEQUENTIAL);
+    }
+    close(fd); // la projection reste valide
+#endif
+  }
+
+  ~mmapFile() {
+#ifdef _WIN32
+    if(data != NULL) UnmapViewOfFile(data);
+    if(mapping != NULL) CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    if(data != NULL) munmap((void *) data, length);
+#endif
+  }
+
+  mmapFile(const mmapFile &) = delete;
+  mmapFile & operator=(const mmapFile &) = delete;
+
+  const char * begin() const {
+    return data;
+  }
+
+  const char * end() const {
+    return data + length;
+  }
+
+  size_t size() const {
+    return length;
+  }
+};
+
+#endif
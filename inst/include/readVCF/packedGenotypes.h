@@ -0,0 +1,139 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include "lineTile.h"
+
+#ifndef _packedGenotypes_
+#define _packedGenotypes_
+
+// génotypes 0, 1, 2, 3 (NA) stockés sur 2 bits, 4 par octet, comme dans
+// un .bed de PLINK : une ligne de (nsamples + 3)/4 octets par SNP, le
+// premier sample dans les bits de poids faible. Les codes sont ceux de
+// VCFstringToGeno (ce ne sont pas ceux de PLINK)
+//
+// peut être passé à VCFlineGenotypes à la place d'un std::vector<scalar> :
+// les génotypes sont ajoutés avec push_back, une ligne par SNP
+class packedGenotypes {
+  private:
+
+  size_t nsamples;
+  size_t bytesPerSNP;
+  size_t nsnps;   // lignes complètes
+  size_t k;       // nombre de génotypes dans la ligne en cours
+  size_t done;    // nombre de SNPs au dernier appel de endSNP
+  std::vector<uint8_t> data;
+
+  public:
+  typedef uint8_t value_type;
+
+  explicit packedGenotypes(size_t nsamples_)
+    : nsamples(nsamples_), bytesPerSNP((nsamples_ + 3) / 4), nsnps(0), k(0), done(0) {}
+
+  void reserve(size_t n) {
+    data.reserve(n * bytesPerSNP);
+  }
+
+  void push_back(uint8_t g) {
+    if(k == 0) data.resize(data.size() + bytesPerSNP, 0);
+    data[nsnps * bytesPerSNP + (k >> 2)] |= (g & 3) << ((k & 3) << 1);
+    if(++k == nsamples) {
+      k = 0;
+      nsnps++;
+    }
+  }
+
+  // à appeler après chaque SNP ; un SNP sans génotypes (pas de champ GT)
+  // est mis à NA. Renvoie false si le nombre de génotypes est incorrect
+  bool endSNP() {
+    if(k != 0) return false;
+    if(nsnps == done) {
+      for(size_t j = 0; j < nsamples; j++) push_back(3);
+      if(nsamples == 0) nsnps++;
+    }
+    bool ok = (nsnps == done + 1);
+    done = nsnps;
+    return ok;
+  }
+
+  // ajoute les SNPs de x (même nombre de samples) à la suite
+  void append(const packedGenotypes & x) {
+    if(x.nsamples != nsamples || k != 0 || x.k != 0)
+      throw std::runtime_error("packedGenotypes : can't append");
+    data.insert(data.end(), x.data.begin(), x.data.begin() + x.nsnps * bytesPerSNP);
+    nsnps += x.nsnps;
+    done = nsnps;
+  }
+
+  // ajoute n SNPs déjà codés (n lignes de rowBytes() octets)
+  void appendRows(const uint8_t * rows, size_t n) {
+    if(k != 0)
+      throw std::runtime_error("packedGenotypes : can't append");
+    data.insert(data.end(), rows, rows + n * bytesPerSNP);
+    nsnps += n;
+    done = nsnps;
+  }
+
+  void clear() {
+    data.clear();
+    nsnps = 0;
+    k = 0;
+    done = 0;
+  }
+
+  size_t nSNPs() const {
+    return nsnps;
+  }
+
+  size_t nSamples() const {
+    return nsamples;
+  }
+
+  size_t rowBytes() const {
+    return bytesPerSNP;
+  }
+
+  const uint8_t * row(size_t snp) const {
+    return &data[snp * bytesPerSNP];
+  }
+
+  // nombre de NA (code 3) d'un SNP ; les bits de remplissage sont à 0
+  size_t countNA(size_t snp) const {
+    const uint8_t * r = row(snp);
+    size_t n = 0;
+    for(size_t i = 0; i < bytesPerSNP; i++) {
+      uint8_t c = r[i] & (r[i] >> 1) & 0x55;
+      n += (c & 1) + ((c >> 2) & 1) + ((c >> 4) & 1) + ((c >> 6) & 1);
+    }
+    return n;
+  }
+
+  int get(size_t snp, size_t sample) const {
+    return (data[snp * bytesPerSNP + (sample >> 2)] >> ((sample & 3) << 1)) & 3;
+  }
+
+  // décode tous les génotypes d'un SNP, dest[j * stride] pour le sample j
+  template<typename scalar>
+  void decodeSNP(size_t snp, scalar * dest, size_t stride) const {
+    const uint8_t * r = row(snp);
+    for(size_t j = 0; j < nsamples; j++)
+      dest[j * stride] = (r[j >> 2] >> ((j & 3) << 1)) & 3;
+  }
+
+  // les SNPs [first, first + n) dans les lignes 0 à n - 1 de dest, une matrice
+  // variants x samples column-major de ld lignes : par paquets de 64 SNPs
+  // décodés puis transposés (cf lineTile.h)
+  template<typename scalar>
+  void decodeRows(size_t first, size_t n, scalar * dest, size_t ld) const {
+    const size_t T = 64;
+    std::vector<scalar> buf(std::min(T, n) * nsamples);
+    for(size_t i0 = 0; i0 < n; i0 += T) {
+      size_t m = std::min(T, n - i0);
+      for(size_t i = 0; i < m; i++) decodeSNP(first + i0 + i, &buf[i * nsamples], 1);
+      transposeBlocks(buf.data(), m, nsamples, nsamples, dest + i0, ld);
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,205 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include <future>
+#include <algorithm>
+#include "threadPool.h"
+#include "countNewlines.h"
+
+#ifndef _parallelLines_
+#define _parallelLines_
+
+// ajoute des lignes complètes (terminées par '\n') à buf jusqu'à dépasser size octets
+// (Reader : tout type avec nextLine, cf lineReader) ; renvoie le nombre de lignes lues
+template<typename Reader>
+size_t readLinesChunk(Reader & in, std::string & buf, size_t size) {
+  const char * b;
+  const char * e;
+  size_t n = 0;
+  buf.clear();
+  buf.reserve(size + (size >> 4));
+  while(buf.size() < size && in.nextLine(b, e)) {
+    buf.append(b, e);
+    buf += '\n';
+    n++;
+  }
+  return n;
+}
+
+// découpe le morceau [b, e) (des lignes terminées par '\n', sauf peut-être
+// la dernière) en pool->size() sous-morceaux alignés sur les fins de lignes,
+// et lance work(slot0 + t, ...) sur chaque ligne du sous-morceau t, puis flush(slot0 + t).
+// first = numéro de la première ligne ; renvoie le nombre de lignes
+template<typename W, typename F>
+size_t dispatchLines(threadPool * pool, const char * b, const char * e, size_t first, int slot0,
+                     W & work, F & flush, std::vector< std::future<void> > & jobs) {
+  int nt = pool->size();
+  size_t n0 = first;
+  for(int t = 0; t < nt && b < e; t++) {
+    const char * te = (t == nt - 1) ? e : b + (e - b) / (nt - t);
+    if(te < e) {
+      te = (const char *) memchr(te, '\n', e - te);
+      te = (te == NULL) ? e : te + 1;
+    }
+    size_t n = countNewlines(b, te);
+    if(te[-1] != '\n') n++;
+    int slot = slot0 + t;
+    jobs.push_back(pool->push([b, te, first, slot, &work, &flush] {
+      const char * l = b;
+      size_t i = first;
+      while(l < te) {
+        const char * nl = (const char *) memchr(l, '\n', te - l);
+        if(nl == NULL) nl = te;
+        work(slot, l, nl, i++);
+        l = nl + 1;
+      }
+      flush(slot);
+    }));
+    first += n;
+    b = te;
+  }
+  return first - n0;
+}
+
+// attend toutes les tâches avant de propager une éventuelle erreur
+inline void waitJobs(std::vector< std::future<void> > & jobs) {
+  for(std::future<void> & j : jobs) j.wait();
+  std::vector< std::future<void> > J;
+  J.swap(jobs);
+  for(std::future<void> & j : J) j.get();
+}
+
+// Lecture parallèle des lignes d'un Reader (tout type avec nextLine)
+// Le fichier est lu par morceaux d'environ chunkSize octets. Chaque morceau est
+// découpé en pool->size() sous-morceaux alignés sur les fins de lignes, traités
+// par le pool de threads pendant que le thread principal lit le morceau suivant.
+//
+//  work(slot, begin, end, index) est appelé depuis un thread du pool pour chaque
+//     ligne [begin, end) (sans le '\n', index = numéro de la ligne dans le fichier) ;
+//     les lignes d'un sous-morceau sont traitées dans l'ordre, dans le même slot
+//  merge(slot) est appelé depuis le thread principal, sous-morceau par sous-morceau,
+//     dans l'ordre du fichier, pour récupérer les résultats du slot
+//  check(nlines) est appelé depuis le thread principal avant de lancer le
+//     traitement d'un morceau, avec le nombre total de lignes lues jusque là
+//  flush(slot) (facultatif) est appelé depuis le thread du pool quand le slot a fini
+//     un sous-morceau, c'est-à-dire une suite de lignes consécutives, avant merge(slot) ;
+//     sans pool, une seule fois, à la fin du fichier
+//
+// Il y a 2 * pool->size() slots (deux morceaux en cours), numérotés à partir de 0.
+// Sans pool, tout est fait sur le thread principal avec un seul slot.
+// !! work ne doit pas appeler l'API R !!
+// Renvoie le nombre de lignes lues.
+template<typename Reader, typename W, typename M, typename C, typename F>
+size_t parallelLines(Reader & in, threadPool * pool, size_t chunkSize, W work, M merge, C check, F flush) {
+  size_t nlines = 0;
+  if(pool == NULL) {
+    const char * b;
+    const char * e;
+    while(in.nextLine(b, e)) {
+      check(nlines + 1);
+      work(0, b, e, nlines++);
+      merge(0);
+    }
+    flush(0);
+    return nlines;
+  }
+
+  int nt = pool->size();
+  std::string buf[2];
+  std::vector< std::future<void> > jobs[2];
+  try {
+    int cur = 0;
+    size_t n = readLinesChunk(in, buf[cur], chunkSize);
+    if(n > 0) {
+      check(nlines + n);
+      nlines += dispatchLines(pool, buf[cur].data(), buf[cur].data() + buf[cur].size(), nlines, 0, work, flush, jobs[cur]);
+    }
+    while(n > 0) {
+      // le morceau suivant est lu pendant le traitement du morceau courant
+      int nxt = 1 - cur;
+      n = readLinesChunk(in, buf[nxt], chunkSize);
+      waitJobs(jobs[cur]);
+      for(int t = 0; t < nt; t++) merge(cur * nt + t);
+      if(n > 0) {
+        check(nlines + n);
+        nlines += dispatchLines(pool, buf[nxt].data(), buf[nxt].data() + buf[nxt].size(), nlines, nxt * nt, work, flush, jobs[nxt]);
+      }
+      cur = nxt;
+    }
+  } catch(...) {
+    // aucune tâche ne doit survivre aux buffers
+    for(int k = 0; k < 2; k++)
+      for(std::future<void> & j : jobs[k]) j.wait();
+    throw;
+  }
+  return nlines;
+}
+
+template<typename Reader, typename W, typename M, typename C>
+size_t parallelLines(Reader & in, threadPool * pool, size_t chunkSize, W work, M merge, C check) {
+  return parallelLines(in, pool, chunkSize, work, merge, check, [](int) {});
+}
+
+// la même chose sur des lignes déjà en mémoire (fichier projeté), sans copie :
+// les morceaux sont pris directement dans [begin, end)
+template<typename W, typename M, typename C, typename F>
+size_t parallelLines(const char * begin, const char * end, threadPool * pool, size_t chunkSize, W work, M merge, C check, F flush) {
+  size_t nlines = 0;
+  if(pool == NULL) {
+    const char * l = begin;
+    while(l < end) {
+      const char * nl = (const char *) memchr(l, '\n', end - l);
+      if(nl == NULL) nl = end;
+      check(nlines + 1);
+      work(0, l, nl, nlines++);
+      merge(0);
+      l = nl + 1;
+    }
+    flush(0);
+    return nlines;
+  }
+
+  // la fin du morceau qui commence en b
+  auto chunkEnd = [end, chunkSize](const char * b) {
+    if((size_t) (end - b) <= chunkSize) return end;
+    const char * e = (const char *) memchr(b + chunkSize, '\n', end - b - chunkSize);
+    return e == NULL ? end : e + 1;
+  };
+
+  int nt = pool->size();
+  std::vector< std::future<void> > jobs[2];
+  try {
+    int cur = 0;
+    const char * b = begin;
+    const char * e = chunkEnd(b);
+    if(b < e) {
+      check(nlines + countNewlines(b, e) + (e[-1] != '\n'));
+      nlines += dispatchLines(pool, b, e, nlines, 0, work, flush, jobs[cur]);
+    }
+    while(b < e) {
+      // deux morceaux en cours, pour ne pas attendre le plus lent des threads
+      int nxt = 1 - cur;
+      b = e;
+      e = chunkEnd(b);
+      if(b < e) {
+        check(nlines + countNewlines(b, e) + (e[-1] != '\n'));
+        nlines += dispatchLines(pool, b, e, nlines, nxt * nt, work, flush, jobs[nxt]);
+      }
+      waitJobs(jobs[cur]);
+      for(int t = 0; t < nt; t++) merge(cur * nt + t);
+      cur = nxt;
+    }
+  } catch(...) {
+    for(int k = 0; k < 2; k++)
+      for(std::future<void> & j : jobs[k]) j.wait();
+    throw;
+  }
+  return nlines;
+}
+
+template<typename W, typename M, typename C>
+size_t parallelLines(const char * begin, const char * end, threadPool * pool, size_t chunkSize, W work, M merge, C check) {
+  return parallelLines(begin, end, pool, chunkSize, work, merge, check, [](int) {});
+}
+
+#endif
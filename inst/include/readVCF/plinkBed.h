@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "packedGenotypes.h"
+#include "constStringStreamLite.h"
+
+#ifndef _plinkBed_
+#define _plinkBed_
+
+// Écriture d'un fichier PLINK binaire prefix.bed / .bim / .fam, variant
+// par variant (mode SNP-major) : rien n'est gardé en mémoire.
+// Dans le .bim, A1 = ALT et A2 = REF (comme plink --vcf) ; les codes du .bed
+// sont 00 = A1/A1, 10 = hétérozygote, 11 = A2/A2, 01 = manquant
+// Les génotypes arrivent par lignes de packedGenotypes, qui ont déjà la
+// disposition d'un .bed : il suffit de recoder chaque octet par une table
+class plinkBedWriter {
+  private:
+
+  std::string prefix;
+  FILE * bed;
+  FILE * bim;
+  size_t nsamples;
+  uint8_t recode[256];
+  uint8_t lastMask; // bits utiles du dernier octet de chaque ligne
+  std::vector<uint8_t> buf;
+
+  static FILE * open(const std::string & path) {
+    FILE * f = fopen(path.c_str(), "wb");
+    if(f == NULL)
+      throw std::runtime_error("Couldn't create " + path + "\n");
+    return f;
+  }
+
+  static void write(const void * p, size_t n, FILE * f) {
+    if(n > 0 && fwrite(p, 1, n, f) != n)
+      throw std::runtime_error("Couldn't write PLINK files\n");
+  }
+
+  public:
+  plinkBedWriter(const std::string & prefix_, const std::vector<std::string> & samples)
+    : prefix(prefix_), bed(NULL), bim(NULL), nsamples(samples.size()) {
+    // 0, 1, 2, 3 (cf VCFstringToGeno) -> codes PLINK
+    static const uint8_t code[4] = {3, 2, 0, 1};
+    for(int x = 0; x < 256; x++)
+      recode[x] = code[x & 3] | (code[(x >> 2) & 3] << 2) | (code[(x >> 4) & 3] << 4) | (code[(x >> 6) & 3] << 6);
+    lastMask = (nsamples % 4 == 0) ? 0xFF : (uint8_t) ((1 << (2 * (nsamples % 4))) - 1);
+
+    FILE * fam = open(prefix + ".fam");
+    std::string s;
+    for(const std::string & id : samples) s += id + ' ' + id + " 0 0 0 -9\n";
+    // le destructeur n'est pas appelé si le constructeur échoue : on ferme
+    // et on supprime ici les fichiers créés (pas le .bim, qui n'a pas pu l'être)
+    try {
+      write(s.data(), s.size(), fam);
+      FILE * f = fam;
+      fam = NULL;
+      if(fclose(f) != 0)
+        throw std::runtime_error("Couldn't write PLINK files\n");
+      bed = open(prefix + ".bed");
+      static const uint8_t magic[3] = {0x6c, 0x1b, 0x01};
+      write(magic, 3, bed);
+      bim = open(prefix + ".bim");
+    } catch(...) {
+      if(fam != NULL) fclose(fam);
+      remove((prefix + ".fam").c_str());
+      if(bed != NULL) {
+        fclose(bed);
+        bed = NULL;
+        remove((prefix + ".bed").c_str());
+      }
+      throw;
+    }
+  }
+
+  ~plinkBedWriter() {
+    if(bed != NULL) fclose(bed);
+    if(bim != NULL) fclose(bim);
+  }
+
+  plinkBedWriter(const plinkBedWriter &) = delete;
+  plinkBedWriter & operator=(const plinkBedWriter &) = delete;
+
+  // les SNPs de G, à la suite
+  void writeRows(const packedGenotypes & G) {
+    size_t rb = G.rowBytes();
+    buf.resize(G.nSNPs() * rb);
+    for(size_t i = 0; i < G.nSNPs(); i++) {
+      const uint8_t * r = G.row(i);
+      uint8_t * d = &buf[i * rb];
+      for(size_t k = 0; k < rb; k++) d[k] = recode[r[k]];
+      if(rb > 0) d[rb - 1] &= lastMask;
+    }
+    write(buf.data(), buf.size(), bed);
+  }
+
+  // des lignes du .bim déjà formatées (cf bimLine)
+  void writeBim(const std::string & lines) {
+    write(lines.data(), lines.size(), bim);
+  }
+
+  void close() {
+    int r = fclose(bed) | fclose(bim);
+    bed = bim = NULL;
+    if(r != 0)
+      throw std::runtime_error("Couldn't write PLINK files\n");
+  }
+
+  // en cas d'erreur : supprime les fichiers incomplets
+  void discard() {
+    if(bed != NULL) fclose(bed);
+    if(bim != NULL) fclose(bim);
+    bed = bim = NULL;
+    remove((prefix + ".bed").c_str());
+    remove((prefix + ".bim").c_str());
+    remove((prefix + ".fam").c_str());
+  }
+};
+
+// ajoute à s la ligne du .bim d'un variant :
+// chromosome, identifiant, position génétique (0), position, A1 (ALT), A2 (REF)
+inline void bimLine(std::string & s, const charSpan & chr, const charSpan & id, int pos, const charSpan & ref, const charSpan & alt) {
+  s.append(chr.begin, chr.end);
+  s += '\t';
+  s.append(id.begin, id.end);
+  s += "\t0\t";
+  s += std::to_string(pos);
+  s += '\t';
+  s.append(alt.begin, alt.end);
+  s += '\t';
+  s.append(ref.begin, ref.end);
+  s += '\n';
+}
+
+#endif
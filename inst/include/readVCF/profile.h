@@ -0,0 +1,57 @@
+#include <cstdint>
+#include <chrono>
+
+#ifndef _profile_
+#define _profile_
+
+// temps en nanosecondes (horloge monotone)
+inline uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Compteurs d'une lecture (readVCFgenotypes(..., profile = TRUE)) : un jeu
+// par slot de parallelLines, modifié par un seul thread à la fois, et un
+// pour le thread principal ; ils sont additionnés à la fin (cf add).
+// Les fonctions instrumentées prennent un profileCounters *, NULL par défaut :
+// sans profil, il n'en coûte qu'un test par ligne
+// Les étapes (en ns, additionnées sur tous les threads) :
+//   read : lecture et décompression des lignes (thread principal ; 0 pour un
+//          fichier projeté en mémoire, où la lecture se fait au décodage)
+//   fields : découpage des colonnes fixes et recherche de GT dans FORMAT
+//   genotypes : décodage des génotypes
+//   merge : regroupement des résultats des slots (thread principal)
+//   output : construction des objets R
+struct profileCounters {
+  uint64_t bytes, lines, samples, na;
+  uint64_t readNs, fieldsNs, genotypesNs, mergeNs, outputNs;
+  uint64_t t; // début de l'étape en cours, cf start et lap
+
+  profileCounters() : bytes(0), lines(0), samples(0), na(0), readNs(0), fieldsNs(0),
+                      genotypesNs(0), mergeNs(0), outputNs(0), t(0) {}
+
+  void start() {
+    t = nowNs();
+  }
+
+  // termine l'étape en cours (ajoutée à stage) et commence la suivante
+  void lap(uint64_t & stage) {
+    uint64_t u = nowNs();
+    stage += u - t;
+    t = u;
+  }
+
+  void add(const profileCounters & P) {
+    bytes += P.bytes;
+    lines += P.lines;
+    samples += P.samples;
+    na += P.na;
+    readNs += P.readNs;
+    fieldsNs += P.fieldsNs;
+    genotypesNs += P.genotypesNs;
+    mergeNs += P.mergeNs;
+    outputNs += P.outputNs;
+  }
+};
+
+#endif
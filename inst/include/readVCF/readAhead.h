@@ -0,0 +1,120 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#ifndef _readAhead_
+#define _readAhead_
+
+// Lecture anticipée d'une Source (cf lineReader) : un thread lit les blocs
+// suivants (et les décompresse, pour un fichier gzip) pendant que le thread
+// appelant découpe et décode le bloc courant ; l'attente du disque (ou d'un
+// système de fichiers réseau) se fait en même temps que le calcul.
+// depth blocs de size octets sont recyclés en anneau : la mémoire est bornée,
+// et le thread de lecture attend qu'un bloc soit libéré quand il a de l'avance.
+// Une erreur du thread de lecture est relancée par next, après les blocs déjà lus.
+// La Source n'est plus utilisée une fois l'objet détruit (le thread est arrêté).
+template<typename Source>
+class readAhead {
+  private:
+
+  struct block {
+    std::vector<char> data;
+    size_t n;
+  };
+
+  Source src;
+  std::vector<block> blocks;
+  size_t head;  // premier bloc plein
+  size_t count; // nombre de blocs pleins
+  bool held;    // blocks[head] est en cours d'utilisation (cf next)
+  bool eof, stopping;
+  std::exception_ptr error;
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::thread reader;
+
+  void run() {
+    size_t tail = 0;
+    while(true) {
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this] { return stopping || count < blocks.size(); });
+        if(stopping) return;
+      }
+      // blocks[tail] n'est pas plein : seul ce thread y touche
+      block & b = blocks[tail];
+      b.n = 0;
+      std::exception_ptr e;
+      try {
+        while(b.n < b.data.size()) {
+          size_t k = src.read(b.data.data() + b.n, b.data.size() - b.n);
+          if(k == 0) break;
+          b.n += k;
+        }
+      } catch(...) {
+        e = std::current_exception();
+      }
+      bool last = e || b.n < b.data.size();
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        if(b.n > 0) count++;
+        error = e;
+        eof = last;
+      }
+      cv.notify_all();
+      if(last) return;
+      tail = (tail + 1) % blocks.size();
+    }
+  }
+
+  public:
+  explicit readAhead(Source src_, size_t depth = 3, size_t size = 1 << 22)
+    : src(src_), blocks(depth), head(0), count(0), held(false), eof(false), stopping(false) {
+    for(block & b : blocks) {
+      b.data.resize(size);
+      b.n = 0;
+    }
+    reader = std::thread(&readAhead::run, this);
+  }
+
+  ~readAhead() {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      stopping = true;
+    }
+    cv.notify_all();
+    reader.join();
+  }
+
+  readAhead(const readAhead &) = delete;
+  readAhead & operator=(const readAhead &) = delete;
+
+  // le bloc suivant [b, b + n), sans copie ; il reste valide jusqu'à l'appel
+  // suivant, qui le rend au thread de lecture. false en fin de fichier
+  bool next(const char * & b, size_t & n) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if(held) {
+      head = (head + 1) % blocks.size();
+      count--;
+      held = false;
+      cv.notify_all();
+    }
+    cv.wait(lock, [this] { return count > 0 || eof; });
+    if(count == 0) {
+      if(error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+      }
+      return false;
+    }
+    held = true;
+    b = blocks[head].data.data();
+    n = blocks[head].n;
+    return true;
+  }
+};
+
+#endif
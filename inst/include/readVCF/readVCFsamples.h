@@ -1,3 +1,6 @@
+#include <string>
+#include <vector>
+#include <stdexcept>
 #include "stringStreamLite.h"
 
 
@@ -7,13 +10,13 @@ template<typename T>
 void readVCFsamples(std::string line, T & samples);
 
 template<>
-void readVCFsamples<std::vector<std::string>>(std::string line, std::vector<std::string> & samples) {
+inline void readVCFsamples<std::vector<std::string>>(std::string line, std::vector<std::string> & samples) {
   stringStreamLite li(line, 9); // 9 = tab separated
   std::string G;
   // 9 champs qui ne sont pas des samples
   for(int i = 0; i < 9; i++) {
     if(!(li >> G))
-      Rcpp::stop("VCF file format error"); // a remplacer par un throw
+      throw std::runtime_error("VCF file format error");
   }
   // on push back les samples
   while(li >> G) {
@@ -0,0 +1,86 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+
+#ifndef _sampleSelection_
+#define _sampleSelection_
+
+// les samples à lire : pour chaque colonne de génotypes du VCF,
+// un booléen "à garder". Les samples gardés sont rendus dans l'ordre du fichier.
+// La sélection par défaut garde tout (et le parseur n'en tient pas compte)
+class sampleSelection {
+  private:
+
+  bool everything;
+  std::vector<bool> mask;
+  size_t nkept;
+  size_t last; // nombre de colonnes à parcourir (jusqu'au dernier sample gardé)
+
+  void setLast() {
+    nkept = 0;
+    last = 0;
+    for(size_t j = 0; j < mask.size(); j++) {
+      if(mask[j]) {
+        nkept++;
+        last = j + 1;
+      }
+    }
+  }
+
+  public:
+  sampleSelection() : everything(true), nkept(0), last(0) {}
+
+  // par les noms
+  sampleSelection(const std::vector<std::string> & samples, const std::vector<std::string> & names)
+    : everything(false), mask(samples.size(), false) {
+    std::map<std::string, size_t> col;
+    for(size_t j = 0; j < samples.size(); j++) col[samples[j]] = j;
+    for(const std::string & s : names) {
+      std::map<std::string, size_t>::const_iterator it = col.find(s);
+      if(it == col.end())
+        throw std::runtime_error("Unknown sample " + s + "\n");
+      mask[it->second] = true;
+    }
+    setLast();
+  }
+
+  // par les indices (à partir de 1, comme dans R)
+  sampleSelection(const std::vector<std::string> & samples, const std::vector<int> & which)
+    : everything(false), mask(samples.size(), false) {
+    for(int i : which) {
+      if(i < 1 || (size_t) i > samples.size())
+        throw std::runtime_error("Sample index out of range\n");
+      mask[i - 1] = true;
+    }
+    setLast();
+  }
+
+  bool all() const {
+    return everything;
+  }
+
+  bool keep(size_t j) const {
+    return everything || mask[j];
+  }
+
+  // nombre de samples gardés (nsamples si tout est gardé)
+  size_t size(size_t nsamples) const {
+    return everything ? nsamples : nkept;
+  }
+
+  size_t end() const {
+    return last;
+  }
+
+  std::vector<std::string> names(const std::vector<std::string> & samples) const {
+    if(everything) return samples;
+    std::vector<std::string> r;
+    r.reserve(nkept);
+    for(size_t j = 0; j < mask.size(); j++)
+      if(mask[j]) r.push_back(samples[j]);
+    return r;
+  }
+};
+
+#endif
@@ -1,32 +1,84 @@
-#include <iostream>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <charconv>
+#include <stdexcept>
+#include "constStringStreamLite.h"
 
 #ifndef _STO_
 #define _STO_
 
+// conversion d'un morceau [b, e) de buffer, sans allocation (std::from_chars)
+// comme std::stoi / std::stod : les blancs initiaux et un '+' sont ignorés,
+// la lecture s'arrête au premier caractère qui ne fait pas partie du nombre ;
+// std::invalid_argument s'il n'y a pas de nombre, std::out_of_range s'il
+// est trop grand
 template<typename T>
-T sto(const std::string & x);
+T sto(const char * b, const char * e);
 
-template<>
-inline double sto<double>(const std::string&x) {
-  return std::stod(x);
+template<typename T>
+inline T stoNumber(const char * b, const char * e) {
+  while(b < e && (*b == ' ' || *b == '\t' || *b == '\n' || *b == '\r')) b++;
+  if(b < e && *b == '+' && (b + 1 == e || b[1] != '-')) b++;
+  T x;
+  std::from_chars_result r = std::from_chars(b, e, x);
+  if(r.ec == std::errc::invalid_argument)
+    throw std::invalid_argument("sto");
+  if(r.ec == std::errc::result_out_of_range)
+    throw std::out_of_range("sto");
+  return x;
 }
 
 template<>
-inline float sto<float>(const std::string&x) {
-  return std::stof(x);
+inline int sto<int>(const char * b, const char * e) {
+  return stoNumber<int>(b, e);
 }
 
 template<>
-inline int sto<int>(const std::string&x) {
-  return std::stoi(x);
+inline long sto<long>(const char * b, const char * e) {
+  return stoNumber<long>(b, e);
 }
 
+// from_chars sur les flottants n'existe pas dans toutes les bibliothèques
+// standard : à défaut on passe par spanToDouble
 template<>
-inline std::string sto<std::string>(const std::string&x) {
-  return x;
+inline double sto<double>(const char * b, const char * e) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  return stoNumber<double>(b, e);
+#else
+  if(b == e)
+    throw std::invalid_argument("sto");
+  return spanToDouble(b, e);
+#endif
 }
 
+template<>
+inline float sto<float>(const char * b, const char * e) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  return stoNumber<float>(b, e);
+#else
+  return sto<double>(b, e);
 #endif
+}
+
+template<>
+inline std::string sto<std::string>(const char * b, const char * e) {
+  return std::string(b, e);
+}
 
+template<>
+inline std::string_view sto<std::string_view>(const char * b, const char * e) {
+  return std::string_view(b, e - b);
+}
+
+template<>
+inline charSpan sto<charSpan>(const char * b, const char * e) {
+  return charSpan(b, e);
+}
+
+// une std::string se convertit implicitement en std::string_view
+template<typename T>
+inline T sto(std::string_view x) {
+  return sto<T>(x.data(), x.data() + x.size());
+}
+
+#endif
@@ -0,0 +1,394 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include "bgzf.h"
+
+#ifndef _TABIX_
+#define _TABIX_
+
+// une région, en coordonnées 1-based, bornes incluses
+struct genomicRegion {
+  std::string chr;
+  int64_t beg;
+  int64_t end;
+};
+
+// "chr", "chr:beg" ou "chr:beg-end" ; les virgules dans les nombres sont ignorées
+inline genomicRegion parseRegion(const std::string & s) {
+  genomicRegion r;
+  r.beg = 1;
+  r.end = INT64_MAX >> 1;
+  size_t colon = s.rfind(':');
+  if(colon == std::string::npos) {
+    r.chr = s;
+    return r;
+  }
+  r.chr = s.substr(0, colon);
+  std::string coords;
+  for(size_t i = colon + 1; i < s.size(); i++)
+    if(s[i] != ',') coords += s[i];
+  char * e;
+  r.beg = strtoll(coords.c_str(), &e, 10);
+  if(e == coords.c_str())
+    throw std::runtime_error("Bad region " + s);
+  if(*e == '-') {
+    const char * b = e + 1;
+    r.end = strtoll(b, &e, 10);
+    if(e == b)
+      throw std::runtime_error("Bad region " + s);
+  }
+  if(*e != 0 || r.beg < 1 || r.end < r.beg)
+    throw std::runtime_error("Bad region " + s);
+  return r;
+}
+
+// tout un contig, quel que soit son nom (qui peut contenir ':', cf parseRegion)
+inline genomicRegion wholeContig(const std::string & chr) {
+  genomicRegion r = {chr, 1, INT64_MAX >> 1};
+  return r;
+}
+
+// un intervalle de virtual offsets [beg, end)
+struct bgzfChunk {
+  uint64_t beg;
+  uint64_t end;
+  bool operator<(const bgzfChunk & o) const { return beg < o.beg; }
+};
+
+// index tabix (.tbi) ou csi (.csi), cf les spécifications de samtools/hts-specs
+class tabixIndex {
+  private:
+
+  struct bin {
+    uint64_t loffset; // csi seulement
+    std::vector<bgzfChunk> chunks;
+  };
+
+  struct reference {
+    std::map<uint32_t, bin> bins;
+    std::vector<uint64_t> ioff; // index linéaire (tbi seulement)
+    uint64_t nMapped;
+    uint64_t nUnmapped;
+  };
+
+  bool csi;
+  int minShift;
+  int depth;
+  std::vector<std::string> names;
+  std::map<std::string, int> ids;
+  std::vector<reference> refs;
+
+  // lecture dans le buffer décompressé
+  const std::string * buf;
+  size_t p;
+
+  void need(size_t n) {
+    if(p + n > buf->size())
+      throw std::runtime_error("Truncated index file");
+  }
+  int32_t i32() {
+    need(4);
+    int32_t x;
+    memcpy(&x, buf->data() + p, 4); // little endian
+    p += 4;
+    return x;
+  }
+  uint32_t u32() {
+    return (uint32_t) i32();
+  }
+  uint64_t u64() {
+    need(8);
+    uint64_t x;
+    memcpy(&x, buf->data() + p, 8);
+    p += 8;
+    return x;
+  }
+
+  // l'en-tête tabix : format, col_seq, col_beg, col_end, meta, skip, l_nm, names
+  void readTabixHeader() {
+    for(int i = 0; i < 6; i++) i32();
+    int32_t l_nm = i32();
+    need(l_nm);
+    const char * s = buf->data() + p;
+    const char * e = s + l_nm;
+    while(s < e) {
+      std::string nm(s);
+      ids[nm] = names.size();
+      names.push_back(nm);
+      s += nm.size() + 1;
+    }
+    p += l_nm;
+  }
+
+  // le bin des méta-données, juste après le dernier bin du dernier niveau
+  // (37450 pour tabix)
+  uint32_t pseudoBin() const {
+    return ((1u << ((depth << 1) + depth + 3)) - 1) / 7 + 1;
+  }
+
+  void parse(const std::string & data) {
+    buf = &data;
+    p = 0;
+    need(4);
+    int32_t n_ref;
+    if(data.compare(0, 4, "TBI\1") == 0) {
+      csi = false;
+      p = 4;
+      minShift = 14;
+      depth = 5;
+      n_ref = i32();
+      readTabixHeader();
+      if((int) names.size() != n_ref)
+        throw std::runtime_error("Malformed tabix index");
+    } else if(data.compare(0, 4, "CSI\1") == 0) {
+      csi = true;
+      p = 4;
+      minShift = i32();
+      depth = i32();
+      int32_t l_aux = i32();
+      size_t auxEnd = p + l_aux;
+      if(l_aux >= 28) readTabixHeader();
+      p = auxEnd;
+      n_ref = i32();
+    } else {
+      throw std::runtime_error("Unknown index format");
+    }
+
+    refs.resize(n_ref);
+    uint32_t pb = pseudoBin();
+    for(int32_t r = 0; r < n_ref; r++) {
+      reference & ref = refs[r];
+      ref.nMapped = 0;
+      ref.nUnmapped = 0;
+      int32_t n_bin = i32();
+      for(int32_t b = 0; b < n_bin; b++) {
+        uint32_t bn = u32();
+        uint64_t loffset = csi ? u64() : 0;
+        int32_t n_chunk = i32();
+        if(bn == pb) { // méta-données : nombre de lignes
+          for(int32_t c = 0; c < n_chunk; c++) {
+            uint64_t a = u64(), z = u64();
+            if(c == 1) {
+              ref.nMapped = a;
+              ref.nUnmapped = z;
+            }
+          }
+          continue;
+        }
+        bin & B = ref.bins[bn];
+        B.loffset = loffset;
+        for(int32_t c = 0; c < n_chunk; c++) {
+          bgzfChunk ch;
+          ch.beg = u64();
+          ch.end = u64();
+          B.chunks.push_back(ch);
+        }
+      }
+      if(!csi) {
+        int32_t n_intv = i32();
+        ref.ioff.resize(n_intv);
+        for(int32_t i = 0; i < n_intv; i++) ref.ioff[i] = u64();
+      }
+    }
+    buf = NULL;
+  }
+
+  public:
+  // le fichier d'index de filename, "" s'il n'y en a pas
+  static std::string indexFile(const std::string & filename) {
+    std::string idx = filename + ".tbi";
+    if(compressionType(idx) == 3) return idx;
+    idx = filename + ".csi";
+    if(compressionType(idx) == 3) return idx;
+    return "";
+  }
+
+  // charge filename.tbi, ou à défaut filename.csi
+  explicit tabixIndex(const std::string & filename) {
+    std::string idx = indexFile(filename);
+    if(idx.empty())
+      throw std::runtime_error("Couldn't find a .tbi or .csi index for " + filename);
+    parse(readBGZFfile(idx));
+  }
+
+  const std::vector<std::string> & sequences() const {
+    return names;
+  }
+
+  // -1 si la séquence n'est pas dans l'index
+  int refId(const std::string & chr) const {
+    std::map<std::string, int>::const_iterator it = ids.find(chr);
+    return it == ids.end() ? -1 : it->second;
+  }
+
+  // nombre de lignes indexées pour une séquence (0 si l'index ne le donne pas)
+  uint64_t nLines(int rid) const {
+    return refs[rid].nMapped + refs[rid].nUnmapped;
+  }
+
+  // nombre total de lignes indexées (0 si l'index ne le donne pas)
+  uint64_t nLines() const {
+    uint64_t n = 0;
+    for(size_t i = 0; i < refs.size(); i++) n += nLines(i);
+    return n;
+  }
+
+  // les intervalles de virtual offsets à lire pour une région, triés et fusionnés
+  std::vector<bgzfChunk> query(const genomicRegion & r) const {
+    std::vector<bgzfChunk> res;
+    int rid = refId(r.chr);
+    if(rid < 0 || rid >= (int) refs.size()) return res;
+    const reference & ref = refs[rid];
+
+    // coordonnées 0-based [beg, end)
+    int64_t beg = r.beg - 1, end = r.end;
+    int s = minShift + (depth << 1) + depth;
+    int64_t maxPos = (int64_t) 1 << s;
+    if(end > maxPos) end = maxPos;
+    if(beg >= end) return res;
+
+    // offset minimal : index linéaire (tbi) ou loffset du plus petit bin
+    // existant contenant beg (csi)
+    uint64_t minOff = 0;
+    if(!csi) {
+      if(!ref.ioff.empty()) {
+        size_t i = beg >> minShift;
+        minOff = ref.ioff[std::min(i, ref.ioff.size() - 1)];
+      }
+    } else {
+      uint32_t first = ((1u << ((depth << 1) + depth)) - 1) / 7; // premier bin du dernier niveau
+      int64_t bn = first + (beg >> minShift);
+      for(; bn >= 0; bn = bn == 0 ? -1 : (bn - 1) >> 3) {
+        std::map<uint32_t, bin>::const_iterator it = ref.bins.find(bn);
+        if(it != ref.bins.end()) {
+          minOff = it->second.loffset;
+          break;
+        }
+      }
+    }
+
+    // reg2bins
+    --end;
+    uint32_t t = 0;
+    for(int l = 0; l <= depth; s -= 3, t += 1u << ((l << 1) + l), l++) {
+      uint32_t b = t + (beg >> s), e = t + (end >> s);
+      for(uint32_t i = b; i <= e; i++) {
+        std::map<uint32_t, bin>::const_iterator it = ref.bins.find(i);
+        if(it == ref.bins.end()) continue;
+        res.insert(res.end(), it->second.chunks.begin(), it->second.chunks.end());
+      }
+    }
+
+    std::vector<bgzfChunk> merged;
+    std::sort(res.begin(), res.end());
+    for(const bgzfChunk & c : res) {
+      if(c.end <= minOff) continue;
+      if(!merged.empty() && c.beg <= merged.back().end) {
+        merged.back().end = std::max(merged.back().end, c.end);
+      } else {
+        merged.push_back(c);
+      }
+    }
+    return merged;
+  }
+};
+
+// la ligne (une ligne de données VCF) chevauche-t-elle la région ?
+// after = true si la ligne est sur la bonne séquence mais après la région
+inline bool lineInRegion(const char * s, const char * end, const genomicRegion & r, bool & after) {
+  after = false;
+  const char * t1 = (const char *) memchr(s, '\t', end - s);
+  if(t1 == NULL || (size_t) (t1 - s) != r.chr.size() || r.chr.compare(0, std::string::npos, s, t1 - s) != 0)
+    return false;
+  const char * e = t1 + 1;
+  int64_t pos = 0;
+  for(; e < end && *e >= '0' && *e <= '9'; e++) pos = 10*pos + (*e - '0');
+  if(pos > r.end) {
+    after = true;
+    return false;
+  }
+  // la fin du variant est donnée par la longueur de REF
+  int64_t rlen = 1;
+  const char * t3 = (e < end) ? (const char *) memchr(e + 1, '\t', end - e - 1) : NULL; // fin de ID
+  if(t3 != NULL) {
+    const char * t4 = (const char *) memchr(t3 + 1, '\t', end - t3 - 1);
+    if(t4 != NULL) rlen = t4 - t3 - 1;
+  }
+  return pos + rlen - 1 >= r.beg;
+}
+
+inline bool lineInRegion(const std::string & line, const genomicRegion & r, bool & after) {
+  return lineInRegion(line.data(), line.data() + line.size(), r, after);
+}
+
+// lecture des lignes d'un ensemble de régions dans un fichier bgzip indexé
+// les régions sont lues dans l'ordre donné ; un variant présent dans
+// plusieurs régions est lu plusieurs fois
+class regionReader {
+  private:
+
+  bgzfReader & in;
+  const tabixIndex & index;
+  std::vector<genomicRegion> regions;
+  size_t r;
+  std::vector<bgzfChunk> chunks;
+  size_t c;
+  bool inChunk;
+
+  public:
+  // une région qui est le nom exact d'une séquence de l'index est tout ce
+  // contig, même si le nom contient ':' (comme pour htslib)
+  regionReader(bgzfReader & in_, const tabixIndex & index_, const std::vector<std::string> & regions_)
+    : in(in_), index(index_), r(0), c(0), inChunk(false) {
+    for(const std::string & s : regions_)
+      regions.push_back(index.refId(s) >= 0 ? wholeContig(s) : parseRegion(s));
+    if(!regions.empty()) chunks = index.query(regions[0]);
+  }
+
+  regionReader(bgzfReader & in_, const tabixIndex & index_, const std::vector<genomicRegion> & regions_)
+    : in(in_), index(index_), regions(regions_), r(0), c(0), inChunk(false) {
+    if(!regions.empty()) chunks = index.query(regions[0]);
+  }
+
+  // la ligne suivante [b, e), sans copie, cf bgzfReader::nextLine
+  bool nextLine(const char * & b, const char * & e) {
+    while(r < regions.size()) {
+      if(!inChunk) {
+        if(c == chunks.size()) {
+          // région suivante
+          if(++r < regions.size()) chunks = index.query(regions[r]);
+          c = 0;
+          continue;
+        }
+        in.seek(chunks[c].beg);
+        inChunk = true;
+      }
+      bool after;
+      while(in.tell() < chunks[c].end && in.nextLine(b, e)) {
+        if(lineInRegion(b, e, regions[r], after)) return true;
+        if(after) {
+          c = chunks.size() - 1; // inutile de lire les chunks suivants
+          break;
+        }
+      }
+      inChunk = false;
+      c++;
+    }
+    return false;
+  }
+
+  bool getline(std::string & line) {
+    const char * b;
+    const char * e;
+    if(!nextLine(b, e)) return false;
+    line.assign(b, e);
+    return true;
+  }
+};
+
+#endif
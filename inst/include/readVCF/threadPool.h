@@ -0,0 +1,75 @@
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+#ifndef _THREADPOOL_
+#define _THREADPOOL_
+
+// a fixed set of worker threads consuming a FIFO of tasks.
+// push() returns a future : exceptions thrown in a task are re-thrown by get()
+// !! les tâches ne doivent pas appeler l'API R (ni Rcpp::stop) !!
+class threadPool {
+  private:
+
+  std::vector<std::thread> workers;
+  std::deque< std::function<void()> > tasks;
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool stopping;
+
+  void work() {
+    while(true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if(stopping && tasks.empty()) return;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  public:
+  threadPool(int n) : stopping(false) {
+    if(n < 1) n = 1;
+    for(int i = 0; i < n; i++)
+      workers.emplace_back(&threadPool::work, this);
+  }
+
+  ~threadPool() {
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      stopping = true;
+    }
+    cv.notify_all();
+    for(std::thread & w : workers) w.join();
+  }
+
+  threadPool(const threadPool &) = delete;
+  threadPool & operator=(const threadPool &) = delete;
+
+  int size() const {
+    return workers.size();
+  }
+
+  template<typename F>
+  std::future<void> push(F f) {
+    std::shared_ptr< std::packaged_task<void()> > task = std::make_shared< std::packaged_task<void()> >(f);
+    std::future<void> res = task->get_future();
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      tasks.push_back([task] { (*task)(); });
+    }
+    cv.notify_one();
+    return res;
+  }
+};
+
+#endif
@@ -1,19 +1,29 @@
-#include <iostream>
 #include <string>
-#include <sstream>
-#include "stringStreamLite.h"
+#include <string_view>
+#include <cstring>
 #include "sto.h"
+#include "constStringStreamLite.h"
 #ifndef TOKENATPOSITION
 #define TOKENATPOSITION
 
+// le token numéro pos d'un buffer [b, e), sans copie
+// (vide s'il y a moins de pos + 1 tokens)
+inline charSpan tokenAtPosition(const char * b, const char * e, int pos) {
+  for(int i = 0; i < pos; i++) {
+    const char * d = (const char *) memchr(b, ':', e - b);
+    if(d == NULL) return charSpan(e, e);
+    b = d + 1;
+  }
+  const char * d = (const char *) memchr(b, ':', e - b);
+  return charSpan(b, d == NULL ? e : d);
+}
+
+// le token numéro pos de s, converti en T par sto<T> (sans allocation,
+// sauf pour T = std::string)
 template<typename T>
-T tokenAtPosition(std::string & s, int pos) {
-  stringStreamLite ss(s, ':');
-  std::string token;
-  for(int i = 0; i < pos && ss.next_token() != 0; i++) {}
-  ss >> token;
-  T r = sto<T>(token);
-  return r;
+T tokenAtPosition(std::string_view s, int pos) {
+  charSpan t = tokenAtPosition(s.data(), s.data() + s.size(), pos);
+  return sto<T>(t.begin, t.end);
 }
 
 #endif
@@ -1,19 +1,35 @@
 #include <string>
-#include "stringStreamLite.h"
+#include <string_view>
+#include <cstring>
 
 #ifndef _TOKENPOSITION_
 #define _TOKENPOSITION_
 
-template<typename scalar = int>
-scalar tokenPosition(std::string s, std::string token) {
-  stringStreamLite ss(s, ':');
-  std::string tok;
-  scalar k = 0;
-  while( ss >> tok ) {
-    if(tok == token) return k;
+// la position de token dans s (des tokens séparés par ':'), -1 s'il est absent
+// sans allocation
+inline int tokenPosition(std::string_view s, std::string_view token) {
+  const char * b = s.data();
+  const char * e = b + s.size();
+  size_t n = token.size();
+  int k = 0;
+  while(b < e) {
+    const char * d = (const char *) memchr(b, ':', e - b);
+    if(d == NULL) d = e;
+    if((size_t) (d - b) == n && memcmp(b, token.data(), n) == 0) return k;
+    b = d + 1;
     k++;
   }
   return -1;
 }
 
+template<typename scalar = int>
+scalar tokenPosition(std::string_view s, std::string_view token) {
+  return (scalar) tokenPosition(s, token);
+}
+
+// la même chose sur un buffer [b, e)
+inline int tokenPosition(const char * b, const char * e, const char * token) {
+  return tokenPosition(std::string_view(b, e - b), std::string_view(token));
+}
+
 #endif
@@ -0,0 +1,100 @@
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include "constStringStreamLite.h"
+
+#ifndef _variantFilter_
+#define _variantFilter_
+
+// un seuil sur un champ numérique de INFO (la première valeur si
+// le champ en a plusieurs, AF=0.1,0.2) ; faux si le champ est absent
+struct infoThreshold {
+  std::string key;
+  double value;
+  bool min; // true : INFO >= value, false : INFO <= value
+};
+
+// filtres sur les colonnes fixes, évalués avant le décodage des génotypes
+// une ligne rejetée n'est pas lue au delà de INFO
+class variantFilter {
+  public:
+  int minPos, maxPos;     // position dans [minPos, maxPos]
+  bool pass;              // FILTER == "PASS"
+  bool biallelic;         // un seul allèle alternatif
+  std::vector<std::string> flags; // flags de INFO qui doivent être présents
+  std::vector<infoThreshold> thresholds;
+  std::unordered_set<std::string> ids; // ID dans la liste (si elle n'est pas vide)
+
+  variantFilter() : minPos(0), maxPos(2147483647), pass(false), biallelic(false) {}
+
+  bool active() const {
+    return minPos > 0 || maxPos < 2147483647 || pass || biallelic || !flags.empty() || !thresholds.empty() || !ids.empty();
+  }
+
+  // la valeur du champ key de INFO [b, e) ; charSpan(NULL, NULL) si absent
+  // (un flag présent donne un span vide non nul)
+  static charSpan infoField(const char * b, const char * e, const std::string & key) {
+    size_t n = key.size();
+    while(b < e) {
+      const char * d = (const char *) memchr(b, ';', e - b);
+      if(d == NULL) d = e;
+      if((size_t) (d - b) >= n && memcmp(b, key.data(), n) == 0) {
+        if(b + n == d) return charSpan(d, d);
+        if(b[n] == '=') return charSpan(b + n + 1, d);
+      }
+      b = d + 1;
+    }
+    return charSpan();
+  }
+
+  // la valeur numérique [b, e) d'un champ de INFO, sans copie (cf spanToDouble),
+  // sauf si elle ne commence pas par un nombre : strtod décide alors (inf...) ;
+  // false si ce n'est pas un nombre, ou NaN
+  static bool thresholdValue(const char * b, const char * e, double & x) {
+    const char * p = (b < e && (*b == '-' || *b == '+')) ? b + 1 : b;
+    if(p < e && ((*p >= '0' && *p <= '9') || (*p == '.' && p + 1 < e && p[1] >= '0' && p[1] <= '9'))) {
+      x = spanToDouble(b, e);
+    } else {
+      std::string s(b, e);
+      char * endp;
+      x = strtod(s.c_str(), &endp);
+      if(endp == s.c_str()) return false;
+    }
+    return !std::isnan(x);
+  }
+
+  // true si la ligne [b, e) passe tous les filtres
+  bool accept(const char * b, const char * e) const {
+    charSpan f[8]; // CHROM POS ID REF ALT QUAL FILTER INFO
+    for(int k = 0; k < 8; k++) {
+      const char * d = (const char *) memchr(b, '\t', e - b);
+      if(d == NULL) {
+        if(k < 7) return true; // ligne mal formée : le parseur signalera l'erreur
+        d = e;
+      }
+      f[k] = charSpan(b, d);
+      b = d + 1;
+    }
+    int pos = spanToInt(f[1].begin, f[1].end);
+    if(pos < minPos || pos > maxPos) return false;
+    if(pass && !(f[6] == "PASS")) return false;
+    if(biallelic && (f[4] == "." || memchr(f[4].begin, ',', f[4].size()) != NULL)) return false;
+    for(const std::string & s : flags)
+      if(infoField(f[7].begin, f[7].end, s).begin == NULL) return false;
+    for(const infoThreshold & t : thresholds) {
+      charSpan v = infoField(f[7].begin, f[7].end, t.key);
+      if(v.empty()) return false;
+      const char * c = (const char *) memchr(v.begin, ',', v.size());
+      double x;
+      if(!thresholdValue(v.begin, c == NULL ? v.end : c, x)) return false;
+      if(t.min ? x < t.value : x > t.value) return false;
+    }
+    if(!ids.empty() && ids.find(f[2].str()) == ids.end()) return false;
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "constStringStreamLite.h"
+#include "VCFsnpInfo.h"
+
+#ifndef _variantTable_
+#define _variantTable_
+
+// des chaînes mises bout à bout dans un seul buffer, avec leurs offsets :
+// pas d'allocation par chaîne
+class stringArena {
+  private:
+
+  std::string data;
+  std::vector<size_t> offsets; // la chaîne i est data[offsets[i], offsets[i + 1])
+
+  public:
+  stringArena() : offsets(1, 0) {}
+
+  size_t size() const {
+    return offsets.size() - 1;
+  }
+
+  void push_back(const charSpan & s) {
+    data.append(s.begin, s.end);
+    offsets.push_back(data.size());
+  }
+
+  void push_back(const std::string & s) {
+    push_back(charSpan(s.data(), s.data() + s.size()));
+  }
+
+  charSpan operator[](size_t i) const {
+    return charSpan(data.data() + offsets[i], data.data() + offsets[i + 1]);
+  }
+
+  void append(const stringArena & A) {
+    size_t base = data.size();
+    data += A.data;
+    for(size_t i = 1; i < A.offsets.size(); i++) offsets.push_back(base + A.offsets[i]);
+  }
+
+  void reserve(size_t n) {
+    offsets.reserve(n + 1);
+  }
+
+  void clear() {
+    data.clear();
+    offsets.assign(1, 0);
+  }
+
+  // pour l'écriture du cache (cf VCFcache.h)
+  const std::string & bytes() const {
+    return data;
+  }
+
+  size_t offset(size_t i) const {
+    return offsets[i];
+  }
+};
+
+// des chaînes, chaque chaîne distincte n'étant gardée qu'une fois (une
+// stringArena) : la chaîne i est la chaîne distincte code(i). Les doublons
+// ne coûtent que leur code ; une table de hachage (adressage ouvert, des
+// codes dans la stringArena) retrouve les chaînes déjà vues. Chaque chaîne
+// distincte coûte en plus son hachage et sa place dans la table : pour les
+// colonnes où il y a peu de chaînes distinctes (REF, ALT)
+class internedArena {
+  private:
+
+  // une case de la table : un code, et le hachage de sa chaîne (comparé
+  // avant les chaînes elles-mêmes)
+  struct slot {
+    uint32_t code;
+    uint32_t hash;
+  };
+
+  stringArena strings; // les chaînes distinctes
+  std::vector<uint32_t> hashes; // leurs hachages
+  std::vector<uint32_t> codes;
+  std::vector<slot> table; // code NONE : case vide ; taille : une puissance de 2
+  static const uint32_t NONE = UINT32_MAX;
+
+  static uint32_t hash(const charSpan & s) {
+    uint64_t h = 14695981039346656037ull; // FNV-1a
+    for(const char * p = s.begin; p < s.end; p++) h = (h ^ (unsigned char) *p) * 1099511628211ull;
+    return (uint32_t) (h ^ (h >> 32));
+  }
+
+  void grow() {
+    std::vector<slot> old(std::max(table.size() * 2, (size_t) 64), slot{NONE, 0});
+    old.swap(table);
+    size_t mask = table.size() - 1;
+    for(uint32_t k = 0; k < strings.size(); k++) {
+      size_t h = hashes[k] & mask;
+      while(table[h].code != NONE) h = (h + 1) & mask;
+      table[h] = slot{k, hashes[k]};
+    }
+  }
+
+  // le code de s, de hachage hs
+  uint32_t intern(const charSpan & s, uint32_t hs) {
+    if(table.empty() && strings.size() == 0) {
+      // la table n'est faite qu'à la deuxième chaîne (les slots de
+      // parallelLines sans pool n'ont qu'un variant)
+      strings.push_back(s);
+      hashes.push_back(hs);
+      return 0;
+    }
+    if(2 * (strings.size() + 1) > table.size()) grow();
+    size_t mask = table.size() - 1;
+    size_t h = hs & mask;
+    for(; table[h].code != NONE; h = (h + 1) & mask) {
+      if(table[h].hash != hs) continue;
+      charSpan t = strings[table[h].code];
+      if(t.size() == s.size() && memcmp(t.begin, s.begin, s.size()) == 0) return table[h].code;
+    }
+    if(strings.size() == NONE)
+      throw std::runtime_error("Too many distinct strings\n");
+    uint32_t k = strings.size();
+    table[h] = slot{k, hs};
+    strings.push_back(s);
+    hashes.push_back(hs);
+    return k;
+  }
+
+  public:
+  size_t size() const {
+    return codes.size();
+  }
+
+  // nombre de chaînes distinctes
+  size_t distinct() const {
+    return strings.size();
+  }
+
+  // le code de s (une nouvelle chaîne distincte si elle n'a pas encore été vue)
+  uint32_t intern(const charSpan & s) {
+    return intern(s, hash(s));
+  }
+
+  void push_back(const charSpan & s) {
+    codes.push_back(intern(s));
+  }
+
+  void push_back(const std::string & s) {
+    push_back(charSpan(s.data(), s.data() + s.size()));
+  }
+
+  uint32_t code(size_t i) const {
+    return codes[i];
+  }
+
+  // la chaîne distincte k
+  charSpan unique(size_t k) const {
+    return strings[k];
+  }
+
+  charSpan operator[](size_t i) const {
+    return strings[codes[i]];
+  }
+
+  // les chaînes distinctes de A ne sont cherchées qu'une fois chacune,
+  // avec leur hachage déjà calculé
+  void append(const internedArena & A) {
+    if(A.distinct() == 1) { // un seul variant (parallelLines sans pool)
+      uint32_t k = intern(A.unique(0), A.hashes[0]);
+      for(size_t i = 0; i < A.size(); i++) codes.push_back(k);
+      return;
+    }
+    std::vector<uint32_t> recode(A.distinct());
+    for(size_t k = 0; k < A.distinct(); k++) recode[k] = intern(A.unique(k), A.hashes[k]);
+    for(uint32_t c : A.codes) codes.push_back(recode[c]);
+  }
+
+  void reserve(size_t n) {
+    codes.reserve(n);
+  }
+
+  // garde la place de la table (les slots de parallelLines sont vidés à chaque morceau)
+  void clear() {
+    strings.clear();
+    hashes.clear();
+    codes.clear();
+    std::fill(table.begin(), table.end(), slot{NONE, 0});
+  }
+};
+
+// les noms des contigs, codés par des entiers (à partir de 0)
+// dans l'ordre où ils sont rencontrés
+class contigTable {
+  private:
+
+  std::vector<std::string> names;
+  std::unordered_map<std::string, int> codes;
+  int last;
+
+  public:
+  contigTable() : last(-1) {}
+
+  // les lignes d'un même contig se suivent : on compare d'abord au précédent
+  int code(const charSpan & s) {
+    if(last >= 0 && names[last].size() == s.size() && memcmp(names[last].data(), s.begin, s.size()) == 0)
+      return last;
+    std::string k(s.begin, s.end);
+    std::unordered_map<std::string, int>::const_iterator it = codes.find(k);
+    if(it != codes.end()) {
+      last = it->second;
+    } else {
+      last = names.size();
+      codes[k] = last;
+      names.push_back(k);
+    }
+    return last;
+  }
+
+  int code(const std::string & s) {
+    return code(charSpan(s.data(), s.data() + s.size()));
+  }
+
+  const std::vector<std::string> & contigs() const {
+    return names;
+  }
+
+  void clear() {
+    names.clear();
+    codes.clear();
+    last = -1;
+  }
+};
+
+// les colonnes CHROM, POS, ID, REF, ALT d'un ensemble de variants,
+// en colonnes (ID seul si full = false)
+class variantTable {
+  public:
+  bool full;
+  contigTable contigs;
+  std::vector<int> chr; // codes dans contigs
+  std::vector<int> pos;
+  stringArena id; // presque tous distincts : pas d'internedArena
+  internedArena ref, alt;
+
+  explicit variantTable(bool full_ = false) : full(full_) {}
+
+  size_t size() const {
+    return id.size();
+  }
+
+  template<typename chrT, typename strT>
+  void push_back(const VCFsnpInfo<chrT, strT> & snp) {
+    id.push_back(snp.id);
+    if(full) {
+      chr.push_back(contigs.code(snp.chr));
+      pos.push_back(snp.pos);
+      ref.push_back(snp.ref);
+      alt.push_back(snp.alt);
+    }
+  }
+
+  void reserve(size_t n) {
+    id.reserve(n);
+    if(full) {
+      chr.reserve(n);
+      pos.reserve(n);
+      ref.reserve(n);
+      alt.reserve(n);
+    }
+  }
+
+  // ajoute les variants de T (les codes des contigs sont traduits)
+  void append(const variantTable & T) {
+    id.append(T.id);
+    if(full) {
+      std::vector<int> recode;
+      for(const std::string & s : T.contigs.contigs()) recode.push_back(contigs.code(s));
+      for(int c : T.chr) chr.push_back(recode[c]);
+      pos.insert(pos.end(), T.pos.begin(), T.pos.end());
+      ref.append(T.ref);
+      alt.append(T.alt);
+    }
+  }
+
+  void clear() {
+    contigs.clear();
+    chr.clear();
+    pos.clear();
+    id.clear();
+    ref.clear();
+    alt.clear();
+  }
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include <cstring>
+#include <Rcpp.h>
+#include "variantTable.h"
+
+#ifndef _variantTableR_
+#define _variantTableR_
+
+// conversion d'une variantTable en objets R (thread principal seulement)
+
+// les chaînes A[from..to) (A : tout type dont operator[] donne un charSpan,
+// stringArena ou cachedArena), converties en CHARSXP en un seul passage et
+// écrites dans x à partir de x[at]. Seuls "." et une chaîne égale à la
+// précédente (ID répétés, variants multialléliques éclatés) reprennent le
+// CHARSXP déjà fait ; les autres doublons passent par la table des chaînes
+// de R. Ce CHARSXP est protégé puisqu'il est déjà dans x
+template<typename Arena>
+void spansToR(const Arena & A, size_t from, size_t to, Rcpp::CharacterVector & x, size_t at) {
+  SEXP dot = NULL, prev = NULL;
+  charSpan p;
+  for(size_t i = from; i < to; i++) {
+    charSpan s = A[i];
+    bool isDot = s.size() == 1 && *s.begin == '.';
+    SEXP c;
+    if(isDot && dot != NULL) {
+      c = dot;
+    } else if(prev != NULL && s.size() == p.size() && memcmp(s.begin, p.begin, s.size()) == 0) {
+      c = prev;
+    } else {
+      c = Rf_mkCharLen(s.begin, s.size());
+      if(isDot) dot = c;
+    }
+    SET_STRING_ELT(x, at + (i - from), c);
+    prev = c;
+    p = s;
+  }
+}
+
+// une internedArena : un seul CHARSXP par chaîne distincte, fait à sa
+// première occurrence (et protégé par x à partir de là)
+inline void spansToR(const internedArena & A, size_t from, size_t to, Rcpp::CharacterVector & x, size_t at) {
+  std::vector<SEXP> made(A.distinct(), NULL);
+  for(size_t i = from; i < to; i++) {
+    uint32_t k = A.code(i);
+    if(made[k] == NULL) {
+      charSpan s = A.unique(k);
+      made[k] = Rf_mkCharLen(s.begin, s.size());
+    }
+    SET_STRING_ELT(x, at + (i - from), made[k]);
+  }
+}
+
+// les chaînes d'une arena, converties en CHARSXP une seule fois à la fin
+template<typename Arena>
+Rcpp::CharacterVector arenaToR(const Arena & A) {
+  Rcpp::CharacterVector x(A.size());
+  spansToR(A, 0, A.size(), x, 0);
+  return x;
+}
+
+// les contigs de V, sous forme de chaînes (un CHARSXP par contig)
+inline Rcpp::CharacterVector contigsToR(const variantTable & V) {
+  Rcpp::CharacterVector names = Rcpp::wrap(V.contigs.contigs());
+  Rcpp::CharacterVector x(V.size());
+  for(size_t i = 0; i < V.size(); i++) SET_STRING_ELT(x, i, STRING_ELT(names, V.chr[i]));
+  return x;
+}
+
+// CHROM (facteur), POS, ID, REF, ALT
+inline Rcpp::DataFrame variantsToR(const variantTable & V) {
+  Rcpp::IntegerVector chr(V.size());
+  for(size_t i = 0; i < V.size(); i++) chr[i] = V.chr[i] + 1;
+  chr.attr("levels") = Rcpp::wrap(V.contigs.contigs());
+  chr.attr("class") = "factor";
+  return Rcpp::DataFrame::create(Rcpp::Named("chr") = chr, Rcpp::Named("pos") = Rcpp::wrap(V.pos),
+    Rcpp::Named("id") = arenaToR(V.id), Rcpp::Named("ref") = arenaToR(V.ref), Rcpp::Named("alt") = arenaToR(V.alt),
+    Rcpp::Named("stringsAsFactors") = false);
+}
+
+#endif
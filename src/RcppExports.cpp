@@ -10,14 +10,220 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
-// readVCFgenotypes
-SEXP readVCFgenotypes(std::string filename);
-RcppExport SEXP _readVCF_readVCFgenotypes(SEXP filenameSEXP) {
+// readVCFcache
+SEXP readVCFcache(std::string filename, int from, int to, bool packed, bool info, std::string layout, bool lazy);
+RcppExport SEXP _readVCF_readVCFcache(SEXP filenameSEXP, SEXP fromSEXP, SEXP toSEXP, SEXP packedSEXP, SEXP infoSEXP, SEXP layoutSEXP, SEXP lazySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< int >::type from(fromSEXP);
+    Rcpp::traits::input_parameter< int >::type to(toSEXP);
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    Rcpp::traits::input_parameter< bool >::type info(infoSEXP);
+    Rcpp::traits::input_parameter< std::string >::type layout(layoutSEXP);
+    Rcpp::traits::input_parameter< bool >::type lazy(lazySEXP);
+    rcpp_result_gen = Rcpp::wrap(readVCFcache(filename, from, to, packed, info, layout, lazy));
+    return rcpp_result_gen;
+END_RCPP
+}
+// buildVCFindex
+Rcpp::NumericVector buildVCFindex(std::string filename, int step);
+RcppExport SEXP _readVCF_buildVCFindex(SEXP filenameSEXP, SEXP stepSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< int >::type step(stepSEXP);
+    rcpp_result_gen = Rcpp::wrap(buildVCFindex(filename, step));
+    return rcpp_result_gen;
+END_RCPP
+}
+// VCFdims
+Rcpp::NumericVector VCFdims(std::string filename, int threads);
+RcppExport SEXP _readVCF_VCFdims(SEXP filenameSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(VCFdims(filename, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// VCFinfo
+Rcpp::List VCFinfo(std::string filename, int threads, bool count);
+RcppExport SEXP _readVCF_VCFinfo(SEXP filenameSEXP, SEXP threadsSEXP, SEXP countSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type count(countSEXP);
+    rcpp_result_gen = Rcpp::wrap(VCFinfo(filename, threads, count));
+    return rcpp_result_gen;
+END_RCPP
+}
+// VCFopen
+SEXP VCFopen(std::string filename, int threads, Rcpp::Nullable<Rcpp::CharacterVector> region);
+RcppExport SEXP _readVCF_VCFopen(SEXP filenameSEXP, SEXP threadsSEXP, SEXP regionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type region(regionSEXP);
+    rcpp_result_gen = Rcpp::wrap(VCFopen(filename, threads, region));
+    return rcpp_result_gen;
+END_RCPP
+}
+// VCFnextBlock
+SEXP VCFnextBlock(SEXP x, int n);
+RcppExport SEXP _readVCF_VCFnextBlock(SEXP xSEXP, SEXP nSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type n(nSEXP);
+    rcpp_result_gen = Rcpp::wrap(VCFnextBlock(x, n));
+    return rcpp_result_gen;
+END_RCPP
+}
+// VCFclose
+void VCFclose(SEXP x);
+RcppExport SEXP _readVCF_VCFclose(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    VCFclose(x);
+    return R_NilValue;
+END_RCPP
+}
+// VCFsummary
+Rcpp::DataFrame VCFsummary(std::string filename, int threads, Rcpp::Nullable<Rcpp::CharacterVector> region);
+RcppExport SEXP _readVCF_VCFsummary(SEXP filenameSEXP, SEXP threadsSEXP, SEXP regionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type region(regionSEXP);
+    rcpp_result_gen = Rcpp::wrap(VCFsummary(filename, threads, region));
+    return rcpp_result_gen;
+END_RCPP
+}
+// VCFtoBed
+Rcpp::NumericVector VCFtoBed(std::string filename, std::string prefix, int threads, Rcpp::Nullable<Rcpp::CharacterVector> region);
+RcppExport SEXP _readVCF_VCFtoBed(SEXP filenameSEXP, SEXP prefixSEXP, SEXP threadsSEXP, SEXP regionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< std::string >::type prefix(prefixSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type region(regionSEXP);
+    rcpp_result_gen = Rcpp::wrap(VCFtoBed(filename, prefix, threads, region));
+    return rcpp_result_gen;
+END_RCPP
+}
+// packedDim
+Rcpp::IntegerVector packedDim(SEXP x);
+RcppExport SEXP _readVCF_packedDim(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(packedDim(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// packedSNPs
+Rcpp::IntegerMatrix packedSNPs(SEXP x, Rcpp::IntegerVector which);
+RcppExport SEXP _readVCF_packedSNPs(SEXP xSEXP, SEXP whichSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type which(whichSEXP);
+    rcpp_result_gen = Rcpp::wrap(packedSNPs(x, which));
+    return rcpp_result_gen;
+END_RCPP
+}
+// packedSamples
+Rcpp::IntegerMatrix packedSamples(SEXP x, Rcpp::IntegerVector which);
+RcppExport SEXP _readVCF_packedSamples(SEXP xSEXP, SEXP whichSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type which(whichSEXP);
+    rcpp_result_gen = Rcpp::wrap(packedSamples(x, which));
+    return rcpp_result_gen;
+END_RCPP
+}
+// readVCFalleles
+Rcpp::List readVCFalleles(std::string filename, int threads, Rcpp::Nullable<Rcpp::CharacterVector> region, std::string mode);
+RcppExport SEXP _readVCF_readVCFalleles(SEXP filenameSEXP, SEXP threadsSEXP, SEXP regionSEXP, SEXP modeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type region(regionSEXP);
+    Rcpp::traits::input_parameter< std::string >::type mode(modeSEXP);
+    rcpp_result_gen = Rcpp::wrap(readVCFalleles(filename, threads, region, mode));
+    return rcpp_result_gen;
+END_RCPP
+}
+// readVCFcontigs
+SEXP readVCFcontigs(std::string filename, int threads, bool split);
+RcppExport SEXP _readVCF_readVCFcontigs(SEXP filenameSEXP, SEXP threadsSEXP, SEXP splitSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type split(splitSEXP);
+    rcpp_result_gen = Rcpp::wrap(readVCFcontigs(filename, threads, split));
+    return rcpp_result_gen;
+END_RCPP
+}
+// readVCFdosages
+SEXP readVCFdosages(std::string filename, int threads, Rcpp::Nullable<Rcpp::CharacterVector> region, std::string field, std::string type);
+RcppExport SEXP _readVCF_readVCFdosages(SEXP filenameSEXP, SEXP threadsSEXP, SEXP regionSEXP, SEXP fieldSEXP, SEXP typeSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
-    rcpp_result_gen = Rcpp::wrap(readVCFgenotypes(filename));
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type region(regionSEXP);
+    Rcpp::traits::input_parameter< std::string >::type field(fieldSEXP);
+    Rcpp::traits::input_parameter< std::string >::type type(typeSEXP);
+    rcpp_result_gen = Rcpp::wrap(readVCFdosages(filename, threads, region, field, type));
+    return rcpp_result_gen;
+END_RCPP
+}
+// readVCFgenotypes
+SEXP readVCFgenotypes(std::vector<std::string> filename, int threads, Rcpp::Nullable<Rcpp::CharacterVector> region, bool presize, bool packed, bool mmap, SEXP samples, Rcpp::Nullable<Rcpp::List> filter, bool info, bool cache, std::string layout, bool profile, Rcpp::Nullable<Rcpp::IntegerVector> variants, bool lazy);
+RcppExport SEXP _readVCF_readVCFgenotypes(SEXP filenameSEXP, SEXP threadsSEXP, SEXP regionSEXP, SEXP presizeSEXP, SEXP packedSEXP, SEXP mmapSEXP, SEXP samplesSEXP, SEXP filterSEXP, SEXP infoSEXP, SEXP cacheSEXP, SEXP layoutSEXP, SEXP profileSEXP, SEXP variantsSEXP, SEXP lazySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type region(regionSEXP);
+    Rcpp::traits::input_parameter< bool >::type presize(presizeSEXP);
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    Rcpp::traits::input_parameter< bool >::type mmap(mmapSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type samples(samplesSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type filter(filterSEXP);
+    Rcpp::traits::input_parameter< bool >::type info(infoSEXP);
+    Rcpp::traits::input_parameter< bool >::type cache(cacheSEXP);
+    Rcpp::traits::input_parameter< std::string >::type layout(layoutSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::IntegerVector> >::type variants(variantsSEXP);
+    Rcpp::traits::input_parameter< bool >::type lazy(lazySEXP);
+    rcpp_result_gen = Rcpp::wrap(readVCFgenotypes(filename, threads, region, presize, packed, mmap, samples, filter, info, cache, layout, profile, variants, lazy));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -66,17 +272,71 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// test5
+Rcpp::NumericVector test5(std::string filename);
+RcppExport SEXP _readVCF_test5(SEXP filenameSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    rcpp_result_gen = Rcpp::wrap(test5(filename));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test6
+Rcpp::NumericVector test6(std::string filename, std::string region);
+RcppExport SEXP _readVCF_test6(SEXP filenameSEXP, SEXP regionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< std::string >::type region(regionSEXP);
+    rcpp_result_gen = Rcpp::wrap(test6(filename, region));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test7
+Rcpp::NumericVector test7(std::string filename);
+RcppExport SEXP _readVCF_test7(SEXP filenameSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    rcpp_result_gen = Rcpp::wrap(test7(filename));
+    return rcpp_result_gen;
+END_RCPP
+}
 
+void lazyGenotypesInit(DllInfo* dll);
 static const R_CallMethodDef CallEntries[] = {
-    {"_readVCF_readVCFgenotypes", (DL_FUNC) &_readVCF_readVCFgenotypes, 1},
+    {"_readVCF_readVCFcache", (DL_FUNC) &_readVCF_readVCFcache, 7},
+    {"_readVCF_buildVCFindex", (DL_FUNC) &_readVCF_buildVCFindex, 2},
+    {"_readVCF_VCFdims", (DL_FUNC) &_readVCF_VCFdims, 2},
+    {"_readVCF_VCFinfo", (DL_FUNC) &_readVCF_VCFinfo, 3},
+    {"_readVCF_VCFopen", (DL_FUNC) &_readVCF_VCFopen, 3},
+    {"_readVCF_VCFnextBlock", (DL_FUNC) &_readVCF_VCFnextBlock, 2},
+    {"_readVCF_VCFclose", (DL_FUNC) &_readVCF_VCFclose, 1},
+    {"_readVCF_VCFsummary", (DL_FUNC) &_readVCF_VCFsummary, 3},
+    {"_readVCF_VCFtoBed", (DL_FUNC) &_readVCF_VCFtoBed, 4},
+    {"_readVCF_packedDim", (DL_FUNC) &_readVCF_packedDim, 1},
+    {"_readVCF_packedSNPs", (DL_FUNC) &_readVCF_packedSNPs, 2},
+    {"_readVCF_packedSamples", (DL_FUNC) &_readVCF_packedSamples, 2},
+    {"_readVCF_readVCFalleles", (DL_FUNC) &_readVCF_readVCFalleles, 4},
+    {"_readVCF_readVCFcontigs", (DL_FUNC) &_readVCF_readVCFcontigs, 3},
+    {"_readVCF_readVCFdosages", (DL_FUNC) &_readVCF_readVCFdosages, 5},
+    {"_readVCF_readVCFgenotypes", (DL_FUNC) &_readVCF_readVCFgenotypes, 14},
     {"_readVCF_test1", (DL_FUNC) &_readVCF_test1, 1},
     {"_readVCF_test2", (DL_FUNC) &_readVCF_test2, 2},
     {"_readVCF_test3", (DL_FUNC) &_readVCF_test3, 2},
     {"_readVCF_test4", (DL_FUNC) &_readVCF_test4, 0},
+    {"_readVCF_test5", (DL_FUNC) &_readVCF_test5, 1},
+    {"_readVCF_test6", (DL_FUNC) &_readVCF_test6, 2},
+    {"_readVCF_test7", (DL_FUNC) &_readVCF_test7, 1},
     {NULL, NULL, 0}
 };
 
 RcppExport void R_init_readVCF(DllInfo *dll) {
     R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
     R_useDynamicSymbols(dll, FALSE);
+    lazyGenotypesInit(dll);
 }
@@ -0,0 +1,94 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <Rcpp.h>
+#include "VCFcache.h"
+#include "packedGenotypes.h"
+#include "lazyGenotypes.h"
+#include "variantTableR.h"
+
+// cf lazyGenotypes.cpp
+SEXP lazyGenotypesToR(lazyGenotypes * L);
+
+// lecture du cache écrit par readVCFgenotypes(..., cache = TRUE)
+
+static Rcpp::CharacterVector cachedStrings(const cachedArena & A, size_t first, size_t last) {
+  Rcpp::CharacterVector x(last - first);
+  spansToR(A, first, last, x, 0);
+  return x;
+}
+
+// les SNPs from à to (à partir de 1 ; to = -1 : jusqu'au dernier) du cache
+// de filename, sous la même forme que readVCFgenotypes
+// (matrice, ou packedGenotypes si packed = TRUE ; avec info = TRUE, une liste
+// avec le data frame des variants ; layout, cf readVCFgenotypes)
+// lazy = TRUE : la matrice est décodée à la demande depuis le cache projeté en
+// mémoire, cf lazyGenotypes.cpp
+// [[Rcpp::export]]
+SEXP readVCFcache(std::string filename, int from = 1, int to = -1, bool packed = false, bool info = false,
+                  std::string layout = "variants", bool lazy = false) {
+  if(layout != "variants" && layout != "samples")
+    Rcpp::stop("layout should be \"variants\" or \"samples\"\n");
+  if(packed && lazy)
+    Rcpp::stop("packed and lazy can't be both TRUE\n");
+  std::string path = VCFcacheFile(filename);
+  uint64_t size;
+  int64_t mtime;
+  if(!fileStamp(path, size, mtime))
+    Rcpp::stop("No cache for " + filename + "\n");
+  std::shared_ptr<VCFcache> pc = std::make_shared<VCFcache>(path);
+  VCFcache & C = *pc;
+  if(!C.matches(filename))
+    Rcpp::stop("The cache of " + filename + " is out of date (readVCFgenotypes(..., cache = TRUE) updates it)\n");
+  size_t first = from - 1, last = (to < 0) ? C.nsnps : (size_t) to;
+  if(from < 1 || last < first || last > C.nsnps)
+    Rcpp::stop("Variant range out of bounds\n");
+  size_t n = last - first;
+
+  Rcpp::CharacterVector ids = cachedStrings(C.id, first, last);
+  Rcpp::CharacterVector samples = cachedStrings(C.samples, 0, C.nsamples);
+  SEXP res;
+  if(packed) {
+    Rcpp::XPtr<packedGenotypes> P(new packedGenotypes(C.nsamples), true);
+    P->appendRows(C.row(first), n);
+    P.attr("snps") = ids;
+    P.attr("samples") = samples;
+    P.attr("class") = "packedGenotypes";
+    res = P;
+  } else {
+    bool byVariants = (layout == "variants");
+    Rcpp::RObject G;
+    if(lazy) {
+      G = lazyGenotypesToR(new lazyGenotypes(pc, first, n, byVariants));
+      G.attr("dim") = Rcpp::Dimension(byVariants ? n : C.nsamples, byVariants ? C.nsamples : n);
+    } else {
+      Rcpp::IntegerMatrix M(byVariants ? n : C.nsamples, byVariants ? C.nsamples : n);
+      for(size_t i = 0; i < n; i++) {
+        if(byVariants)
+          C.decodeSNP(first + i, &M[i], n);
+        else
+          C.decodeSNP(first + i, &M[i * C.nsamples], 1);
+      }
+      G = M;
+    }
+    Rcpp::List dimNames(2);
+    dimNames[0] = byVariants ? ids : samples;
+    dimNames[1] = byVariants ? samples : ids;
+    G.attr("dimnames") = dimNames;
+    res = G;
+  }
+  if(!info)
+    return res;
+
+  Rcpp::IntegerVector chr(n), pos(n);
+  for(size_t i = 0; i < n; i++) {
+    chr[i] = C.chr[first + i] + 1;
+    pos[i] = C.pos[first + i];
+  }
+  chr.attr("levels") = cachedStrings(C.contigs, 0, C.contigs.n);
+  chr.attr("class") = "factor";
+  Rcpp::DataFrame snps = Rcpp::DataFrame::create(Rcpp::Named("chr") = chr, Rcpp::Named("pos") = pos,
+    Rcpp::Named("id") = ids, Rcpp::Named("ref") = cachedStrings(C.ref, first, last),
+    Rcpp::Named("alt") = cachedStrings(C.alt, first, last), Rcpp::Named("stringsAsFactors") = false);
+  return Rcpp::List::create(Rcpp::Named("genotypes") = res, Rcpp::Named("snps") = snps);
+}
@@ -0,0 +1,23 @@
+#include <string>
+#include <vector>
+#include <Rcpp.h>
+#include "VCFindex.h"
+
+// Index d'un VCF non compressé (filename.rvi, cf VCFindex.h) : l'offset du début
+// de chaque bloc d'au plus step lignes d'un même contig, avec CHROM et POS.
+// readVCFgenotypes(..., region = ) et (..., variants = ) s'en servent pour ne lire
+// que les blocs utiles, d'autant plus vite que le fichier est projeté en mémoire
+// (mmap = TRUE) ; le nombre de lignes (VCFdims) en est aussi tiré.
+// Un index qui ne correspond plus au fichier (taille ou date) est ignoré, ou
+// signalé pour une région : il faut le refaire.
+// Renvoie le nombre de variants et de blocs
+// [[Rcpp::export]]
+Rcpp::NumericVector buildVCFindex(std::string filename, int step = 1000) {
+  size_t nlines, nblocks;
+  writeVCFindex(filename, VCFindexFile(filename), step < 1 ? 0 : step, nlines, nblocks);
+  Rcpp::NumericVector d(2);
+  d[0] = nlines;
+  d[1] = nblocks;
+  d.attr("names") = Rcpp::wrap(std::vector<std::string>{"variants", "blocks"});
+  return d;
+}
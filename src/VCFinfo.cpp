@@ -0,0 +1,80 @@
+#include <string>
+#include <vector>
+#include <Rcpp.h>
+#include "VCFreader.h"
+#include "VCFheader.h"
+
+// nombre de variants et de samples, sans lire les génotypes :
+// d'après l'index (.tbi / .csi quand il donne le nombre de lignes, ou
+// celui de buildVCFindex pour un fichier non compressé),
+// sinon en comptant les fins de lignes
+// [[Rcpp::export]]
+Rcpp::NumericVector VCFdims(std::string filename, int threads = 1) {
+  VCFreader in(filename, threads, std::vector<std::string>(), true);
+  Rcpp::NumericVector d(2);
+  d[0] = in.countLines();
+  d[1] = in.samples.size();
+  d.attr("names") = Rcpp::wrap(std::vector<std::string>{"variants", "samples"});
+  return d;
+}
+
+// les lignes de l'en-tête de type key=<ID=...,...>, en data frame
+static Rcpp::DataFrame headerTable(const std::vector<VCFheaderLine> & H, const std::string & key,
+                                   const std::vector<std::string> & fields) {
+  std::vector< std::vector<std::string> > cols(fields.size());
+  for(const VCFheaderLine & h : H) {
+    if(h.key != key || !h.structured()) continue;
+    for(size_t k = 0; k < fields.size(); k++) cols[k].push_back(h.field(fields[k]));
+  }
+  Rcpp::List L(fields.size());
+  for(size_t k = 0; k < fields.size(); k++) L[k] = Rcpp::wrap(cols[k]);
+  std::vector<std::string> names;
+  for(const std::string & f : fields) names.push_back(f == "ID" ? "id" : std::string(1, tolower(f[0])) + f.substr(1));
+  L.attr("names") = Rcpp::wrap(names);
+  return Rcpp::DataFrame(L);
+}
+
+// le contenu de l'en-tête : samples, contigs, champs INFO / FORMAT / FILTER,
+// les autres lignes "##key=value" dans meta, le nombre de variants
+// (si count = TRUE, cf VCFdims) et la présence d'un index (indexed : tabix,
+// ou celui de buildVCFindex s'il est à jour)
+// [[Rcpp::export]]
+Rcpp::List VCFinfo(std::string filename, int threads = 1, bool count = true) {
+  VCFreader in(filename, threads, std::vector<std::string>(), true);
+  std::vector<VCFheaderLine> H;
+  for(const std::string & l : in.header) H.push_back(VCFheaderLine(l));
+
+  // ##contig=<ID=2,length=243199373>
+  std::vector<std::string> contigs;
+  std::vector<double> lengths;
+  std::vector<std::string> metaKeys, metaValues;
+  for(const VCFheaderLine & h : H) {
+    if(h.key == "contig" && h.structured()) {
+      contigs.push_back(h.field("ID"));
+      std::string len = h.field("length");
+      lengths.push_back(len.empty() ? NA_REAL : atof(len.c_str()));
+    } else if(!h.structured()) {
+      metaKeys.push_back(h.key);
+      metaValues.push_back(h.value);
+    }
+  }
+  Rcpp::CharacterVector meta = Rcpp::wrap(metaValues);
+  meta.attr("names") = Rcpp::wrap(metaKeys);
+
+  double nvariants = NA_REAL;
+  if(count) nvariants = in.countLines();
+  bool indexed = in.indexed();
+
+  std::vector<std::string> infoFields = {"ID", "Number", "Type", "Description"};
+  return Rcpp::List::create(
+    Rcpp::Named("samples") = Rcpp::wrap(in.samples),
+    Rcpp::Named("variants") = nvariants,
+    Rcpp::Named("indexed") = indexed,
+    Rcpp::Named("contigs") = Rcpp::DataFrame::create(Rcpp::Named("id") = Rcpp::wrap(contigs),
+                                                     Rcpp::Named("length") = Rcpp::wrap(lengths),
+                                                     Rcpp::Named("stringsAsFactors") = false),
+    Rcpp::Named("INFO") = headerTable(H, "INFO", infoFields),
+    Rcpp::Named("FORMAT") = headerTable(H, "FORMAT", infoFields),
+    Rcpp::Named("FILTER") = headerTable(H, "FILTER", std::vector<std::string>{"ID", "Description"}),
+    Rcpp::Named("meta") = meta);
+}
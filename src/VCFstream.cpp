@@ -0,0 +1,87 @@
+#include <string>
+#include <Rcpp.h>
+#include "VCFstream.h"
+#include "variantTableR.h"
+
+// lecture par blocs : VCFopen / VCFnextBlock / VCFclose
+
+static VCFstream * streamPointer(SEXP x) {
+  if(TYPEOF(x) != EXTPTRSXP || !Rcpp::inherits(x, "VCFstream"))
+    Rcpp::stop("Not a VCFstream object\n");
+  Rcpp::XPtr<VCFstream> P(x);
+  if(P.get() == NULL)
+    Rcpp::stop("VCFstream is closed\n");
+  return P.get();
+}
+
+typedef VCFsnpInfo<charSpan, charSpan> blockSNP;
+
+// une colonne des variants d'un bloc, vue comme une arena (cf spansToR)
+struct snpColumn {
+  const std::vector<blockSNP> & snps;
+  charSpan blockSNP::* field;
+  charSpan operator[](size_t i) const {
+    return snps[i].*field;
+  }
+};
+
+static Rcpp::CharacterVector columnToR(const std::vector<blockSNP> & snps, charSpan blockSNP::* field) {
+  Rcpp::CharacterVector x(snps.size());
+  snpColumn c = {snps, field};
+  spansToR(c, 0, snps.size(), x, 0);
+  return x;
+}
+
+// [[Rcpp::export]]
+SEXP VCFopen(std::string filename, int threads = 1, Rcpp::Nullable<Rcpp::CharacterVector> region = R_NilValue) {
+  std::vector<std::string> regions;
+  if(region.isNotNull())
+    regions = Rcpp::as< std::vector<std::string> >(region.get());
+  Rcpp::XPtr<VCFstream> P(new VCFstream(filename, threads, regions), true);
+  P.attr("samples") = Rcpp::wrap(P->samples());
+  P.attr("class") = "VCFstream";
+  return P;
+}
+
+// les n variants suivants : une liste avec la matrice des génotypes
+// (variants x samples) et un data frame des colonnes fixes,
+// NULL quand tout le fichier a été lu
+// [[Rcpp::export]]
+SEXP VCFnextBlock(SEXP x, int n = 10000) {
+  VCFstream * S = streamPointer(x);
+  if(n < 1)
+    Rcpp::stop("n should be positive\n");
+  std::vector<blockSNP> snps; // des vues sur les lignes du bloc
+  const std::vector<std::string> & samples = S->samples();
+  Rcpp::IntegerVector G;
+  size_t nl = S->nextBlock<charSpan, charSpan, int>(n, snps, [&](size_t nl) {
+    G = Rcpp::IntegerVector( (R_xlen_t) (nl * samples.size()) );
+    return G.begin();
+  });
+  if(nl == 0)
+    return R_NilValue;
+
+  Rcpp::CharacterVector id = columnToR(snps, &blockSNP::id);
+  Rcpp::IntegerVector pos(nl);
+  for(size_t i = 0; i < nl; i++) pos[i] = snps[i].pos;
+  G.attr("dim") = Rcpp::Dimension(nl, samples.size());
+  Rcpp::List dimNames(2);
+  dimNames[0] = id;
+  dimNames[1] = Rcpp::wrap(samples);
+  G.attr("dimnames") = dimNames;
+
+  Rcpp::DataFrame snpInfo = Rcpp::DataFrame::create(Rcpp::Named("chr") = columnToR(snps, &blockSNP::chr),
+    Rcpp::Named("pos") = pos, Rcpp::Named("id") = id, Rcpp::Named("ref") = columnToR(snps, &blockSNP::ref),
+    Rcpp::Named("alt") = columnToR(snps, &blockSNP::alt), Rcpp::Named("qual") = columnToR(snps, &blockSNP::qual),
+    Rcpp::Named("filter") = columnToR(snps, &blockSNP::filter), Rcpp::Named("info") = columnToR(snps, &blockSNP::info),
+    Rcpp::Named("stringsAsFactors") = false);
+  return Rcpp::List::create(Rcpp::Named("genotypes") = G, Rcpp::Named("snps") = snpInfo);
+}
+
+// ferme le fichier ; l'objet n'est plus utilisable
+// [[Rcpp::export]]
+void VCFclose(SEXP x) {
+  streamPointer(x);
+  Rcpp::XPtr<VCFstream> P(x);
+  P.release();
+}
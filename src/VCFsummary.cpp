@@ -0,0 +1,88 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <Rcpp.h>
+#include "VCFreader.h"
+#include "VCFsnpInfo.h"
+#include "VCFlineGenotypes.h"
+#include "genotypeCounts.h"
+#include "parallelLines.h"
+#include "variantTable.h"
+#include "variantTableR.h"
+
+// le résumé d'un variant (CHROM, POS, ID, REF, ALT sont dans une variantTable)
+struct summaryLine {
+  genotypeCounts N;
+  double hwe;
+};
+
+// les résultats d'un sous-morceau de lignes (cf parallelLines)
+struct summarySlot {
+  VCFsnpInfo<charSpan, charSpan> snp; // une vue sur la ligne en cours
+  formatCache formats;
+  std::vector<double> buf; // pour HWEexact
+  std::vector<summaryLine> lines;
+  variantTable variants;
+  summarySlot() : variants(true) {}
+};
+
+// Statistiques par variant, sans construire la matrice des génotypes :
+// effectifs des génotypes, fréquence allélique, taux de données manquantes,
+// hétérozygotie et p-valeur du test exact de Hardy-Weinberg
+// [[Rcpp::export]]
+Rcpp::DataFrame VCFsummary(std::string filename, int threads = 1, Rcpp::Nullable<Rcpp::CharacterVector> region = R_NilValue) {
+  std::vector<std::string> regions;
+  if(region.isNotNull())
+    regions = Rcpp::as< std::vector<std::string> >(region.get());
+  // un seul pool, pour les lignes et la décompression (cf VCFreader)
+  std::unique_ptr<threadPool> pool;
+  if(threads > 1) pool.reset(new threadPool(threads));
+  VCFreader in(filename, threads, regions, true, pool.get());
+  size_t nsamples = in.samples.size();
+
+  std::vector<summarySlot> slots(pool ? 2 * threads : 1);
+  size_t chunkSize = (size_t) std::max(threads, 1) << 22;
+
+  std::vector<summaryLine> res;
+  variantTable variants(true);
+  parallelLines(in, pool.get(), chunkSize,
+    [&](int s, const char * b, const char * e, size_t i) {
+      summarySlot & S = slots[s];
+      summaryLine L;
+      VCFlineGenotypes(b, e, S.snp, L.N, S.formats);
+      // sans champ GT, tous les génotypes sont NA (comme dans readVCFgenotypes)
+      if(L.N.total() == 0) L.N.n[3] = nsamples;
+      if(L.N.total() != nsamples)
+        throw std::runtime_error("VCF file format error (wrong number of genotypes, line " + std::to_string(i + 1) + ")\n");
+      L.hwe = HWEexact(L.N.n[0], L.N.n[1], L.N.n[2], S.buf);
+      S.lines.push_back(L);
+      S.variants.push_back(S.snp);
+    },
+    [&](int s) {
+      res.insert(res.end(), slots[s].lines.begin(), slots[s].lines.end());
+      slots[s].lines.clear();
+      variants.append(slots[s].variants);
+      slots[s].variants.clear();
+    },
+    [](size_t) {});
+
+  size_t n = res.size();
+  Rcpp::IntegerVector n0(n), n1(n), n2(n), nNA(n);
+  Rcpp::NumericVector AF(n), missing(n), het(n), HWE(n);
+  for(size_t i = 0; i < n; i++) {
+    const summaryLine & L = res[i];
+    n0[i] = L.N.n[0];
+    n1[i] = L.N.n[1];
+    n2[i] = L.N.n[2];
+    nNA[i] = L.N.n[3];
+    AF[i] = L.N.AF();
+    missing[i] = L.N.missingRate();
+    het[i] = L.N.heterozygosity();
+    HWE[i] = L.hwe;
+  }
+  return Rcpp::DataFrame::create(Rcpp::Named("chr") = contigsToR(variants), Rcpp::Named("pos") = Rcpp::wrap(variants.pos),
+    Rcpp::Named("id") = arenaToR(variants.id), Rcpp::Named("ref") = arenaToR(variants.ref),
+    Rcpp::Named("alt") = arenaToR(variants.alt), Rcpp::Named("n0") = n0, Rcpp::Named("n1") = n1,
+    Rcpp::Named("n2") = n2, Rcpp::Named("nNA") = nNA, Rcpp::Named("AF") = AF, Rcpp::Named("missing") = missing,
+    Rcpp::Named("het") = het, Rcpp::Named("HWE") = HWE, Rcpp::Named("stringsAsFactors") = false);
+}
@@ -0,0 +1,71 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <Rcpp.h>
+#include "VCFreader.h"
+#include "VCFsnpInfo.h"
+#include "VCFlineGenotypes.h"
+#include "packedGenotypes.h"
+#include "plinkBed.h"
+#include "parallelLines.h"
+
+// les résultats d'un sous-morceau de lignes (cf parallelLines)
+struct bedSlot {
+  VCFsnpInfo<charSpan, charSpan> snp;
+  formatCache formats;
+  packedGenotypes G;
+  std::string bim;
+  explicit bedSlot(size_t nsamples) : G(nsamples) {}
+};
+
+// Conversion d'un VCF en fichiers PLINK prefix.bed / .bim / .fam
+// Les lignes sont décodées en parallèle, et les morceaux écrits dans l'ordre
+// du fichier dès qu'ils sont prêts : la mémoire utilisée ne dépend pas du
+// nombre de variants. Comme dans readVCFgenotypes, les génotypes comptent
+// les allèles '1' : un ALT multiple est écrit tel quel dans le .bim.
+// Renvoie le nombre de variants et de samples écrits
+// [[Rcpp::export]]
+Rcpp::NumericVector VCFtoBed(std::string filename, std::string prefix, int threads = 1,
+                             Rcpp::Nullable<Rcpp::CharacterVector> region = R_NilValue) {
+  std::vector<std::string> regions;
+  if(region.isNotNull())
+    regions = Rcpp::as< std::vector<std::string> >(region.get());
+  // un seul pool, pour les lignes et la décompression (cf VCFreader)
+  std::unique_ptr<threadPool> pool;
+  if(threads > 1) pool.reset(new threadPool(threads));
+  VCFreader in(filename, threads, regions, true, pool.get());
+  size_t nsamples = in.samples.size();
+
+  std::vector<bedSlot> slots(pool ? 2 * threads : 1, bedSlot(nsamples));
+  size_t chunkSize = (size_t) std::max(threads, 1) << 22;
+
+  plinkBedWriter W(prefix, in.samples);
+  size_t nlines;
+  try {
+    nlines = parallelLines(in, pool.get(), chunkSize,
+      [&](int s, const char * b, const char * e, size_t) {
+        bedSlot & S = slots[s];
+        VCFlineGenotypes(b, e, S.snp, S.G, S.formats);
+        if(!S.G.endSNP())
+          throw std::runtime_error("VCF file format error (wrong number of genotypes)\n");
+        bimLine(S.bim, S.snp.chr, S.snp.id, S.snp.pos, S.snp.ref, S.snp.alt);
+      },
+      [&](int s) {
+        bedSlot & S = slots[s];
+        W.writeRows(S.G);
+        W.writeBim(S.bim);
+        S.G.clear();
+        S.bim.clear();
+      },
+      [](size_t) {});
+    W.close();
+  } catch(...) {
+    W.discard();
+    throw;
+  }
+  Rcpp::NumericVector d(2);
+  d[0] = nlines;
+  d[1] = nsamples;
+  d.attr("names") = Rcpp::wrap(std::vector<std::string>{"variants", "samples"});
+  return d;
+}
@@ -0,0 +1,104 @@
+#include <climits>
+#include <Rcpp.h>
+#include <R_ext/Altrep.h>
+#include "lazyGenotypes.h"
+
+// La matrice de readVCFgenotypes(..., lazy = TRUE) et readVCFcache(..., lazy = TRUE) :
+// un vecteur ALTREP (classe "lazyGenotypes") dont les génotypes restent sur 2 bits,
+// dans le cache projeté en mémoire ou dans un packedGenotypes (cf lazyGenotypes.h).
+// Les éléments et les morceaux (x[i, j], head...) sont décodés à la demande ;
+// sum() vient des effectifs des codes, sans décoder. Tout le reste passe par
+// DATAPTR, qui décode la matrice une fois pour toutes (data2) : à partir de là
+// c'est une matrice ordinaire. save / saveRDS écrivent une matrice ordinaire.
+// data1 : l'objet lazyGenotypes (pointeur externe), data2 : la matrice décodée, ou NULL
+
+static R_altrep_class_t lazyClass;
+
+static lazyGenotypes * lazyPointer(SEXP x) {
+  return (lazyGenotypes *) R_ExternalPtrAddr(R_altrep_data1(x));
+}
+
+static bool materialized(SEXP x) {
+  return !Rf_isNull(R_altrep_data2(x));
+}
+
+static SEXP materialize(SEXP x) {
+  SEXP d = R_altrep_data2(x);
+  if(Rf_isNull(d)) {
+    lazyGenotypes * L = lazyPointer(x);
+    d = PROTECT(Rf_allocVector(INTSXP, (R_xlen_t) L->size()));
+    L->decode(INTEGER(d));
+    R_set_altrep_data2(x, d);
+    UNPROTECT(1);
+  }
+  return d;
+}
+
+static R_xlen_t lazyLength(SEXP x) {
+  return (R_xlen_t) lazyPointer(x)->size();
+}
+
+static Rboolean lazyInspect(SEXP x, int pre, int deep, int pvec, void (*inspect)(SEXP, int, int, int)) {
+  lazyGenotypes * L = lazyPointer(x);
+  Rprintf("lazyGenotypes %.0f variants x %.0f samples (%s)%s\n", (double) L->nsnps, (double) L->nsamples,
+          L->byVariants ? "variants" : "samples", materialized(x) ? ", materialized" : "");
+  return TRUE;
+}
+
+static void * lazyDataptr(SEXP x, Rboolean writeable) {
+  return DATAPTR(materialize(x));
+}
+
+static const void * lazyDataptrOrNull(SEXP x) {
+  return materialized(x) ? DATAPTR(R_altrep_data2(x)) : NULL;
+}
+
+static int lazyElt(SEXP x, R_xlen_t k) {
+  if(materialized(x)) return INTEGER(R_altrep_data2(x))[k];
+  return lazyPointer(x)->elt(k);
+}
+
+static R_xlen_t lazyGetRegion(SEXP x, R_xlen_t k, R_xlen_t n, int * buf) {
+  R_xlen_t len = lazyLength(x);
+  if(k >= len) return 0;
+  if(n > len - k) n = len - k;
+  if(materialized(x)) {
+    const int * d = INTEGER(R_altrep_data2(x)) + k;
+    for(R_xlen_t i = 0; i < n; i++) buf[i] = d[i];
+  } else {
+    lazyPointer(x)->region(k, n, buf);
+  }
+  return n;
+}
+
+// pas de NA (NA est codé 3) ; une fois décodée, la matrice a pu être modifiée :
+// R fait alors le calcul, comme pour une somme qui dépasse les entiers
+static SEXP lazySum(SEXP x, Rboolean narm) {
+  if(materialized(x)) return NULL;
+  double s = lazyPointer(x)->sum();
+  if(s > INT_MAX) return NULL;
+  return Rf_ScalarInteger((int) s);
+}
+
+static int lazyNoNA(SEXP x) {
+  return materialized(x) ? 0 : 1;
+}
+
+// [[Rcpp::init]]
+void lazyGenotypesInit(DllInfo * dll) {
+  lazyClass = R_make_altinteger_class("lazyGenotypes", "readVCF", dll);
+  R_set_altrep_Length_method(lazyClass, lazyLength);
+  R_set_altrep_Inspect_method(lazyClass, lazyInspect);
+  R_set_altvec_Dataptr_method(lazyClass, lazyDataptr);
+  R_set_altvec_Dataptr_or_null_method(lazyClass, lazyDataptrOrNull);
+  R_set_altinteger_Elt_method(lazyClass, lazyElt);
+  R_set_altinteger_Get_region_method(lazyClass, lazyGetRegion);
+  R_set_altinteger_Sum_method(lazyClass, lazySum);
+  R_set_altinteger_No_NA_method(lazyClass, lazyNoNA);
+}
+
+// le vecteur ALTREP de L (qui lui appartient désormais), sans dim ni dimnames
+SEXP lazyGenotypesToR(lazyGenotypes * L) {
+  Rcpp::XPtr<lazyGenotypes> P(L, true);
+  return R_new_altrep(lazyClass, P, R_NilValue);
+}
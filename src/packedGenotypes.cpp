@@ -0,0 +1,77 @@
+#include <string>
+#include <Rcpp.h>
+#include "packedGenotypes.h"
+
+// accès aux objets renvoyés par readVCFgenotypes(..., packed = TRUE)
+// les indices sont ceux de R (à partir de 1) ; 3 = NA, comme dans la matrice
+
+static packedGenotypes * packedPointer(SEXP x) {
+  if(TYPEOF(x) != EXTPTRSXP || !Rcpp::inherits(x, "packedGenotypes"))
+    Rcpp::stop("Not a packedGenotypes object\n");
+  Rcpp::XPtr<packedGenotypes> P(x);
+  if(P.get() == NULL)
+    Rcpp::stop("packedGenotypes object is no longer valid (saved and reloaded ?)\n");
+  return P.get();
+}
+
+static std::vector<size_t> checkIndices(Rcpp::IntegerVector which, size_t n) {
+  std::vector<size_t> res;
+  res.reserve(which.size());
+  for(int k : which) {
+    if(k == NA_INTEGER || k < 1 || (size_t) k > n)
+      Rcpp::stop("Index out of bounds\n");
+    res.push_back(k - 1);
+  }
+  return res;
+}
+
+static Rcpp::CharacterVector subsetNames(Rcpp::CharacterVector names, const std::vector<size_t> & idx) {
+  Rcpp::CharacterVector res(idx.size());
+  for(size_t i = 0; i < idx.size(); i++) res[i] = names[idx[i]];
+  return res;
+}
+
+// [[Rcpp::export]]
+Rcpp::IntegerVector packedDim(SEXP x) {
+  packedGenotypes * P = packedPointer(x);
+  Rcpp::IntegerVector d(2);
+  d[0] = P->nSNPs();
+  d[1] = P->nSamples();
+  return d;
+}
+
+// une matrice SNPs x samples, pour les SNPs demandés
+// [[Rcpp::export]]
+Rcpp::IntegerMatrix packedSNPs(SEXP x, Rcpp::IntegerVector which) {
+  packedGenotypes * P = packedPointer(x);
+  std::vector<size_t> idx = checkIndices(which, P->nSNPs());
+  size_t n = idx.size();
+  Rcpp::IntegerMatrix G(n, P->nSamples());
+  for(size_t i = 0; i < n; i++)
+    P->decodeSNP(idx[i], &G[i], n);
+  Rcpp::RObject X(x);
+  Rcpp::List dimNames(2);
+  dimNames[0] = subsetNames(X.attr("snps"), idx);
+  dimNames[1] = X.attr("samples");
+  G.attr("dimnames") = dimNames;
+  return G;
+}
+
+// une matrice SNPs x samples, pour les samples demandés
+// [[Rcpp::export]]
+Rcpp::IntegerMatrix packedSamples(SEXP x, Rcpp::IntegerVector which) {
+  packedGenotypes * P = packedPointer(x);
+  std::vector<size_t> idx = checkIndices(which, P->nSamples());
+  size_t n = P->nSNPs();
+  Rcpp::IntegerMatrix G(n, idx.size());
+  for(size_t i = 0; i < n; i++) {
+    for(size_t j = 0; j < idx.size(); j++)
+      G[i + j * n] = P->get(i, idx[j]);
+  }
+  Rcpp::RObject X(x);
+  Rcpp::List dimNames(2);
+  dimNames[0] = X.attr("snps");
+  dimNames[1] = subsetNames(X.attr("samples"), idx);
+  G.attr("dimnames") = dimNames;
+  return G;
+}
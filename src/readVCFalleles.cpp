@@ -0,0 +1,134 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <Rcpp.h>
+#include "VCFreader.h"
+#include "VCFsnpInfo.h"
+#include "VCFgenoDecoder.h"
+#include "variantTable.h"
+#include "variantTableR.h"
+#include "parallelLines.h"
+#include "lineTile.h"
+
+// les résultats d'un sous-morceau de lignes (cf parallelLines)
+struct allelesSlot {
+  VCFsnpInfo<charSpan, charSpan> snp;
+  formatCache formats;
+  variantTable variants;
+  std::vector<int8_t> values; // ligne par ligne, -1 = NA
+  allelesSlot() : variants(true) {}
+};
+
+// Les génotypes des sites multi-alléliques, éclatés en un variant par
+// allèle alternatif (ALT = "A,T" donne deux lignes, ALT = "A" puis "T")
+// mode = "counts" : le nombre de copies de l'allèle, pour toutes les ploïdies,
+//   NA si un allèle du sample est manquant
+// mode = "haplotypes" : deux colonnes par sample (sample.1, sample.2) avec
+//   la présence de l'allèle sur chaque haplotype, dans l'ordre du GT "a|b" ;
+//   NA sur les deux haplotypes d'un hétérozygote non phasé "a/b" (a != b,
+//   l'ordre des allèles n'a pas de sens), pour le second haplotype d'un
+//   sample haploïde, et pour les ploïdies > 2
+// Le résultat est list(genotypes = matrice variants x samples, snps = data frame)
+// [[Rcpp::export]]
+Rcpp::List readVCFalleles(std::string filename, int threads = 1, Rcpp::Nullable<Rcpp::CharacterVector> region = R_NilValue,
+                          std::string mode = "counts") {
+  std::vector<std::string> regions;
+  if(region.isNotNull())
+    regions = Rcpp::as< std::vector<std::string> >(region.get());
+  if(mode != "counts" && mode != "haplotypes")
+    Rcpp::stop("mode should be \"counts\" or \"haplotypes\"\n");
+  bool haplo = (mode == "haplotypes");
+
+  // un seul pool, pour les lignes et la décompression (cf VCFreader)
+  std::unique_ptr<threadPool> pool;
+  if(threads > 1) pool.reset(new threadPool(threads));
+  VCFreader in(filename, threads, regions, true, pool.get());
+  size_t nsamples = in.samples.size();
+  size_t ncols = haplo ? 2 * nsamples : nsamples;
+  std::vector<allelesSlot> slots(pool ? 2 * threads : 1);
+  size_t chunkSize = (size_t) std::max(threads, 1) << 22;
+
+  // les valeurs restent sur un octet, dans les blocs des sous-morceaux (sans
+  // recopie dans un tableau qui grandit), jusqu'à l'allocation de la matrice
+  variantTable variants(true);
+  std::vector< std::vector<int8_t> > blocks;
+  parallelLines(in, pool.get(), chunkSize,
+    [&](int s, const char * b, const char * e, size_t) {
+      allelesSlot & S = slots[s];
+      size_t base = S.values.size();
+      int nalt = 0;
+      VCFlineAlleles(b, e, S.snp, nsamples, S.formats,
+        [&](int n) {
+          nalt = n;
+          S.values.resize(base + n * ncols);
+        },
+        [&](size_t j, const int * alleles, int p, bool phased) {
+          bool unknownPhase = (p == 2 && !phased && alleles[0] != alleles[1]);
+          for(int k = 1; k <= nalt; k++) {
+            int8_t * v = &S.values[base + (k - 1) * ncols];
+            if(haplo) {
+              for(int h = 0; h < 2; h++)
+                v[2*j + h] = (h >= p || p > 2 || alleles[h] < 0 || unknownPhase) ? -1 : (alleles[h] == k);
+            } else {
+              int c = (p == 0) ? -1 : 0;
+              for(int a = 0; a < p && c >= 0; a++)
+                c = alleles[a] < 0 ? -1 : c + (alleles[a] == k);
+              v[j] = c;
+            }
+          }
+        });
+      // une ligne par allèle alternatif
+      VCFsnpInfo<charSpan, charSpan> one = S.snp;
+      const char * a = S.snp.alt.begin;
+      for(int k = 0; k < nalt; k++) {
+        const char * c = (const char *) memchr(a, ',', S.snp.alt.end - a);
+        if(c == NULL) c = S.snp.alt.end;
+        one.alt = charSpan(a, c);
+        S.variants.push_back(one);
+        a = c + 1;
+      }
+    },
+    [&](int s) {
+      variants.append(slots[s].variants);
+      blocks.push_back(std::vector<int8_t>());
+      blocks.back().swap(slots[s].values);
+      slots[s].variants.clear();
+    },
+    [](size_t) {});
+
+  size_t n = variants.size();
+  Rcpp::IntegerMatrix G(n, ncols);
+  int * g = G.begin();
+  // par paquets de 64 variants convertis puis transposés (cf lineTile.h),
+  // chaque bloc étant libéré dès qu'il est copié
+  const size_t T = 64;
+  std::vector<int> buf(T * ncols);
+  size_t i0 = 0;
+  for(std::vector<int8_t> & B : blocks) {
+    size_t m = B.size() / std::max(ncols, (size_t) 1);
+    for(size_t r0 = 0; r0 < m; r0 += T) {
+      size_t t = std::min(T, m - r0);
+      const int8_t * v = &B[r0 * ncols];
+      for(size_t k = 0; k < t * ncols; k++)
+        buf[k] = v[k] < 0 ? NA_INTEGER : v[k];
+      transposeBlocks(buf.data(), t, ncols, ncols, g + i0 + r0, n);
+    }
+    i0 += m;
+    std::vector<int8_t>().swap(B);
+  }
+  std::vector<std::string> cols;
+  for(const std::string & s : in.samples) {
+    if(haplo) {
+      cols.push_back(s + ".1");
+      cols.push_back(s + ".2");
+    } else {
+      cols.push_back(s);
+    }
+  }
+  Rcpp::List dimNames(2);
+  dimNames[0] = arenaToR(variants.id);
+  dimNames[1] = Rcpp::wrap(cols);
+  G.attr("dimnames") = dimNames;
+  return Rcpp::List::create(Rcpp::Named("genotypes") = G, Rcpp::Named("snps") = variantsToR(variants));
+}
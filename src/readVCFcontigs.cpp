@@ -0,0 +1,178 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <Rcpp.h>
+#include "VCFreader.h"
+#include "VCFsnpInfo.h"
+#include "VCFlineGenotypes.h"
+#include "packedGenotypes.h"
+#include "lineTile.h"
+#include "tabix.h"
+#include "bgzf.h"
+#include "parallelLines.h"
+#include "variantTable.h"
+#include "variantTableR.h"
+
+// les variants d'un contig ; les génotypes sont écrits directement dans la
+// matrice finale quand l'index donne le nombre de lignes de chaque contig,
+// sinon ils sont gardés dans packed (2 bits par génotype) jusqu'à la fin
+struct contigGenotypes {
+  stringArena ids;
+  std::vector<int> pos;
+  packedGenotypes packed;
+  explicit contigGenotypes(size_t nsamples) : packed(nsamples) {}
+};
+
+// lecture de tout un contig, avec son propre lecteur bgzip
+// (appelé depuis un thread du pool : pas d'API R)
+// g != NULL : les index.nLines(rid) variants vont dans les lignes 0, 1, ...
+// de g, une matrice variants x samples de ld lignes
+static void readContig(const std::string & filename, const tabixIndex & index, int rid,
+                       size_t nsamples, contigGenotypes & R, int * g, size_t ld) {
+  bgzfReader bz(filename, 1);
+  const std::string & contig = index.sequences()[rid];
+  regionReader rr(bz, index, std::vector<genomicRegion>(1, wholeContig(contig)));
+  size_t n = index.nLines(rid);
+  if(n > 0) {
+    R.ids.reserve(n);
+    R.pos.reserve(n);
+    if(g == NULL) R.packed.reserve(n);
+  }
+  formatCache formats;
+  VCFsnpInfo<charSpan, charSpan> snp; // le contig est déjà connu
+  lineTile<int> tile(nsamples);
+  const char * b;
+  const char * e;
+  size_t i = 0;
+  try {
+    for(; rr.nextLine(b, e); i++) {
+      if(g != NULL) {
+        if(i == n)
+          throw std::runtime_error("More lines than expected in VCF file");
+        VCFlineGenotypes(b, e, snp, tile.next(i, g, ld), 1, nsamples, formats);
+      } else {
+        VCFlineGenotypes(b, e, snp, R.packed, formats);
+        if(!R.packed.endSNP())
+          throw std::runtime_error("VCF file format error (wrong number of genotypes)");
+      }
+      R.ids.push_back(snp.id);
+      R.pos.push_back(snp.pos);
+    }
+  } catch(std::exception & err) {
+    throw std::runtime_error(std::string(err.what()) + " (contig " + contig + ", line " + std::to_string(i + 1) + ")\n");
+  }
+  if(g != NULL) {
+    if(i != n)
+      throw std::runtime_error("Fewer lines than expected in VCF file (contig " + contig + ")\n");
+    tile.flush(g, ld);
+  }
+}
+
+// noms et positions des variants de contigs[first..last) pour la matrice G ;
+// decode : les génotypes sont dans les packedGenotypes, à décoder dans G
+static void contigsMatrix(std::vector<contigGenotypes> & contigs, size_t first, size_t last,
+                          const std::vector<std::string> & samples, Rcpp::IntegerMatrix & G, bool decode) {
+  size_t nsnps = G.nrow();
+  Rcpp::CharacterVector ids(nsnps);
+  Rcpp::IntegerVector pos(nsnps);
+  size_t i0 = 0;
+  for(size_t k = first; k < last; k++) {
+    contigGenotypes & R = contigs[k];
+    size_t n = R.ids.size();
+    if(decode) {
+      R.packed.decodeRows(0, n, G.begin() + i0, nsnps);
+      R.packed = packedGenotypes(R.packed.nSamples()); // libérer au fur et à mesure
+    }
+    std::copy(R.pos.begin(), R.pos.end(), pos.begin() + i0);
+    spansToR(R.ids, 0, n, ids, i0);
+    i0 += n;
+  }
+  Rcpp::List dimNames(2);
+  dimNames[0] = ids;
+  dimNames[1] = Rcpp::wrap(samples);
+  G.attr("dimnames") = dimNames;
+  G.attr("pos") = pos;
+}
+
+// Lecture d'un fichier bgzip indexé contig par contig, chaque contig sur
+// un thread (les contigs sont ceux de l'index, dans l'ordre du fichier)
+// split = FALSE : une matrice variants x samples, avec les attributs "chr"
+//   (facteur, un niveau par contig) et "pos"
+// split = TRUE : une liste nommée, une matrice par contig
+// [[Rcpp::export]]
+SEXP readVCFcontigs(std::string filename, int threads = 1, bool split = false) {
+  VCFreader in(filename, 1);
+  if(compressionType(filename) != 3)
+    Rcpp::stop("Reading by contig needs a bgzip compressed file\n");
+  tabixIndex index(filename);
+  const std::vector<std::string> & contigs = index.sequences();
+  size_t nsamples = in.samples.size();
+
+  size_t nc = contigs.size();
+  std::vector<contigGenotypes> res(nc, contigGenotypes(nsamples));
+
+  // si l'index donne le nombre de lignes de chaque contig, les matrices
+  // sont allouées d'abord et remplies directement par les threads
+  bool counted = true;
+  std::vector<size_t> first(nc + 1, 0);
+  for(size_t k = 0; k < nc; k++) {
+    counted = counted && index.nLines(k) > 0;
+    first[k + 1] = first[k] + index.nLines(k);
+  }
+  std::vector<Rcpp::IntegerMatrix> G(split ? nc : 1);
+  std::vector<int *> dest(nc, (int *) NULL);
+  std::vector<size_t> ld(nc, 0);
+  if(counted) {
+    for(size_t k = 0; k < nc; k++) {
+      if(split) {
+        G[k] = Rcpp::IntegerMatrix(index.nLines(k), nsamples);
+        dest[k] = G[k].begin();
+        ld[k] = index.nLines(k);
+      } else {
+        if(k == 0) G[0] = Rcpp::IntegerMatrix(first[nc], nsamples);
+        dest[k] = G[0].begin() + first[k];
+        ld[k] = first[nc];
+      }
+    }
+  }
+
+  std::unique_ptr<threadPool> pool;
+  if(threads > 1) pool.reset(new threadPool(threads));
+  if(pool) {
+    std::vector< std::future<void> > jobs;
+    for(size_t k = 0; k < nc; k++)
+      jobs.push_back(pool->push([&, k] { readContig(filename, index, k, nsamples, res[k], dest[k], ld[k]); }));
+    waitJobs(jobs);
+  } else {
+    for(size_t k = 0; k < nc; k++)
+      readContig(filename, index, k, nsamples, res[k], dest[k], ld[k]);
+  }
+
+  if(split) {
+    Rcpp::List L(nc);
+    for(size_t k = 0; k < nc; k++) {
+      if(!counted) G[k] = Rcpp::IntegerMatrix(res[k].ids.size(), nsamples);
+      contigsMatrix(res, k, k + 1, in.samples, G[k], !counted);
+      L[k] = G[k];
+    }
+    L.attr("names") = Rcpp::wrap(contigs);
+    return L;
+  }
+
+  if(!counted) {
+    size_t nsnps = 0;
+    for(size_t k = 0; k < nc; k++) nsnps += res[k].ids.size();
+    G[0] = Rcpp::IntegerMatrix(nsnps, nsamples);
+  }
+  contigsMatrix(res, 0, nc, in.samples, G[0], !counted);
+  Rcpp::IntegerVector chr(G[0].nrow());
+  size_t i0 = 0;
+  for(size_t k = 0; k < nc; k++) {
+    for(size_t i = 0; i < res[k].ids.size(); i++) chr[i0 + i] = k + 1;
+    i0 += res[k].ids.size();
+  }
+  chr.attr("levels") = Rcpp::wrap(contigs);
+  chr.attr("class") = "factor";
+  G[0].attr("chr") = chr;
+  return G[0];
+}
@@ -0,0 +1,104 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <Rcpp.h>
+#include "VCFreader.h"
+#include "VCFsnpInfo.h"
+#include "VCFlineDosages.h"
+#include "VCFfield.h"
+#include "variantTable.h"
+#include "variantTableR.h"
+#include "parallelLines.h"
+
+// les résultats d'un sous-morceau de lignes (cf parallelLines)
+struct dosagesSlot {
+  VCFsnpInfo<charSpan, charSpan> snp;
+  formatCache formats;
+  variantTable variants;
+};
+
+// Lecture d'un champ numérique des samples (DS par défaut, ou GP, ...)
+// field = "GP" : trois valeurs par sample, le résultat est un tableau
+//   variants x samples x 3
+// type = "double" : une matrice numeric (NA pour les valeurs manquantes)
+// type = "raw" : virgule fixe sur 8 bits, round(100 * x) (entre 0 et 254),
+//   255 pour les valeurs manquantes ; l'attribut "scale" vaut 0.01
+// [[Rcpp::export]]
+SEXP readVCFdosages(std::string filename, int threads = 1, Rcpp::Nullable<Rcpp::CharacterVector> region = R_NilValue,
+                    std::string field = "DS", std::string type = "double") {
+  std::vector<std::string> regions;
+  if(region.isNotNull())
+    regions = Rcpp::as< std::vector<std::string> >(region.get());
+  if(type != "double" && type != "raw")
+    Rcpp::stop("type should be \"double\" or \"raw\"\n");
+  bool raw = (type == "raw");
+  int nval = (field == "GP") ? 3 : 1;
+
+  // un seul pool, pour les lignes et la décompression (cf VCFreader)
+  std::unique_ptr<threadPool> pool;
+  if(threads > 1) pool.reset(new threadPool(threads));
+  VCFreader in(filename, threads, regions, true, pool.get());
+  size_t nsamples = in.samples.size();
+  std::vector<dosagesSlot> slots(pool ? 2 * threads : 1);
+  size_t chunkSize = (size_t) std::max(threads, 1) << 22;
+
+  // chaque valeur est écrite directement à sa place
+  size_t nsnps = in.countLines();
+  size_t N = nsnps * nsamples * nval;
+  Rcpp::NumericVector D;
+  Rcpp::RawVector Dr;
+  if(raw)
+    Dr = Rcpp::RawVector( (R_xlen_t) N );
+  else
+    D = Rcpp::NumericVector( (R_xlen_t) N );
+  double * d = raw ? NULL : D.begin();
+  Rbyte * dr = raw ? Dr.begin() : NULL;
+  double NA = NA_REAL;
+
+  variantTable variants;
+  variants.reserve(nsnps);
+  size_t nlines = parallelLines(in, pool.get(), chunkSize,
+    [&](int s, const char * b, const char * e, size_t i) {
+      dosagesSlot & S = slots[s];
+      if(nval == 1 && !raw) {
+        VCFlineField<FLOAT_FIELD>(b, e, S.snp, field, d + i, nsnps, nsamples, S.formats, NA);
+      } else if(raw) {
+        VCFlineDosages(b, e, S.snp, field, nval, nsamples, S.formats, [&](size_t j, int k, double x) {
+          dr[i + j * nsnps + k * nsnps * nsamples] = std::isnan(x) ? 255 : (Rbyte) std::min(254.0, std::max(0.0, std::round(100 * x)));
+        });
+      } else {
+        VCFlineDosages(b, e, S.snp, field, nval, nsamples, S.formats, [&](size_t j, int k, double x) {
+          d[i + j * nsnps + k * nsnps * nsamples] = std::isnan(x) ? NA : x;
+        });
+      }
+      S.variants.push_back(S.snp);
+    },
+    [&](int s) {
+      variants.append(slots[s].variants);
+      slots[s].variants.clear();
+    },
+    [&](size_t n) {
+      if(n > nsnps)
+        Rcpp::stop("More lines than expected in VCF file\n");
+    });
+  if(nlines != nsnps)
+    Rcpp::stop("Less lines than expected in VCF file\n");
+
+  Rcpp::List dimNames(nval == 1 ? 2 : 3);
+  dimNames[0] = arenaToR(variants.id);
+  dimNames[1] = Rcpp::wrap(in.samples);
+  Rcpp::IntegerVector dim(nval == 1 ? 2 : 3);
+  dim[0] = nsnps;
+  dim[1] = nsamples;
+  if(nval > 1) dim[2] = nval;
+  if(raw) {
+    Dr.attr("dim") = dim;
+    Dr.attr("dimnames") = dimNames;
+    Dr.attr("scale") = 0.01;
+    return Dr;
+  }
+  D.attr("dim") = dim;
+  D.attr("dimnames") = dimNames;
+  return D;
+}
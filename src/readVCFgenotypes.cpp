@@ -1,44 +1,693 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <memory>
+#include <algorithm>
+#include <cmath>
 #include <Rcpp.h>
-#include "readVCFsamples.h"
+#include "VCFreader.h"
 #include "VCFsnpInfo.h"
 #include "VCFlineGenotypes.h"
+#include "packedGenotypes.h"
+#include "parallelLines.h"
+#include "sampleSelection.h"
+#include "variantFilter.h"
+#include "variantTable.h"
+#include "variantTableR.h"
+#include "VCFcache.h"
+#include "lazyGenotypes.h"
+#include "lineTile.h"
+#include "profile.h"
 
-// [[Rcpp::export]]
-SEXP readVCFgenotypes(std::string filename) {
-  std::ifstream in(filename);   
-  if(!in.good()) {
-    Rcpp::stop("Couldn't open file\n");
-  }
-  std::string line;
-  // first skip header
-  while(std::getline(in, line)) {
-    if(line.substr(0,2) != "##")
-      break;
-  }
-  // on doit être sur la ligne qui contient les samples
-  std::vector<std::string> samples;
-  readVCFsamples(line, samples);
+// cf VCFcache.cpp
+SEXP readVCFcache(std::string filename, int from, int to, bool packed, bool info, std::string layout, bool lazy);
+// cf lazyGenotypes.cpp
+SEXP lazyGenotypesToR(lazyGenotypes * L);
 
-  // maintenant on lit le reste du fichier
-  VCFsnpInfo<int> snp;
-  std::vector<int> genos;
-  std::vector<std::string> SNPids;
-  while(std::getline(in, line)) {
-    VCFlineGenotypes(line, snp, genos);
-    SNPids.push_back(snp.id);
-  }
-
-  // Bricoler une matrice à partir d'un vecteur
-  Rcpp::IntegerVector G = Rcpp::wrap(genos);
-  G.attr("dim") = Rcpp::Dimension( SNPids.size(), samples.size() );
-  // lui ajouter dimnames
+// les résultats d'un sous-morceau de lignes (cf parallelLines)
+struct genotypesSlot {
+  VCFsnpInfo<charSpan, charSpan> snp; // une vue sur la ligne en cours
+  formatCache formats;
+  variantTable variants;
+  packedGenotypes packed;
+  lineTile<int> tile; // layout = "variants", cf lineTile.h
+  profileCounters prof; // profile = TRUE
+  genotypesSlot(size_t nsamples, bool info) : variants(info), packed(nsamples), tile(nsamples) {}
+};
+
+// samples = NULL (tous), des noms ou des indices (à partir de 1)
+static sampleSelection selectSamples(SEXP which, const std::vector<std::string> & samples) {
+  if(Rf_isNull(which))
+    return sampleSelection();
+  if(TYPEOF(which) == STRSXP)
+    return sampleSelection(samples, Rcpp::as< std::vector<std::string> >(which));
+  if(TYPEOF(which) == INTSXP)
+    return sampleSelection(samples, Rcpp::as< std::vector<int> >(which));
+  if(TYPEOF(which) == REALSXP) {
+    // pas de conversion silencieuse en entier (2.7 -> 2, NA)
+    Rcpp::NumericVector v(which);
+    std::vector<int> idx;
+    for(R_xlen_t k = 0; k < v.size(); k++) {
+      double x = v[k];
+      if(ISNAN(x) || x != std::floor(x))
+        Rcpp::stop("Sample indices should be whole numbers\n");
+      if(x < 1 || x > (double) samples.size())
+        Rcpp::stop("Sample index out of range\n");
+      idx.push_back((int) x);
+    }
+    return sampleSelection(samples, idx);
+  }
+  Rcpp::stop("samples should be a vector of names or of indices\n");
+}
+
+// filter = NULL, ou une liste avec les éléments (tous facultatifs)
+//   pos = c(min, max), pass = TRUE, biallelic = TRUE,
+//   info = des flags de INFO qui doivent être présents,
+//   infoMin = c(AF = 0.01, ...), infoMax = c(...), ids = les ID à garder
+static variantFilter makeFilter(Rcpp::Nullable<Rcpp::List> filter) {
+  variantFilter F;
+  if(filter.isNull())
+    return F;
+  Rcpp::List L(filter.get());
+  if(L.containsElementNamed("pos")) {
+    std::vector<int> pos = Rcpp::as< std::vector<int> >(L["pos"]);
+    if(pos.size() != 2)
+      Rcpp::stop("filter$pos should be c(min, max)\n");
+    F.minPos = pos[0];
+    F.maxPos = pos[1];
+  }
+  if(L.containsElementNamed("pass")) F.pass = Rcpp::as<bool>(L["pass"]);
+  if(L.containsElementNamed("biallelic")) F.biallelic = Rcpp::as<bool>(L["biallelic"]);
+  if(L.containsElementNamed("info")) F.flags = Rcpp::as< std::vector<std::string> >(L["info"]);
+  for(int m = 0; m < 2; m++) {
+    const char * el = m == 0 ? "infoMin" : "infoMax";
+    if(!L.containsElementNamed(el)) continue;
+    Rcpp::NumericVector v(L[el]);
+    std::vector<std::string> keys = Rcpp::as< std::vector<std::string> >(v.names());
+    for(R_xlen_t k = 0; k < v.size(); k++) {
+      infoThreshold t = { keys[k], v[k], m == 0 };
+      F.thresholds.push_back(t);
+    }
+  }
+  if(L.containsElementNamed("ids")) {
+    std::vector<std::string> ids = Rcpp::as< std::vector<std::string> >(L["ids"]);
+    F.ids.insert(ids.begin(), ids.end());
+  }
+  return F;
+}
+
+// profile = TRUE : les compteurs d'une ligne (cf profile.h)
+static void countLine(profileCounters & P, const char * b, const char * e) {
+  P.bytes += e - b + 1;
+  P.lines++;
+}
+
+static void countGenotypes(profileCounters & P, const int * g, size_t n) {
+  P.samples += n;
+  for(size_t j = 0; j < n; j++) P.na += (g[j] == 3);
+}
+
+// la matrice G (variants x samples, ou samples x variants) : dim et dimnames
+// (G est un vecteur d'entiers, ou l'objet ALTREP de lazyToR)
+static SEXP genotypesToR(SEXP x, const variantTable & variants,
+                         const std::vector<std::string> & sampleNames, bool byVariants, bool info) {
+  Rcpp::RObject G(x);
+  size_t nsamples = sampleNames.size();
   Rcpp::List dimNames(2);
-  dimNames[0] = Rcpp::wrap(SNPids);
-  dimNames[1] = Rcpp::wrap(samples);
+  if(byVariants) {
+    G.attr("dim") = Rcpp::Dimension( variants.size(), nsamples );
+    dimNames[0] = arenaToR(variants.id);
+    dimNames[1] = Rcpp::wrap(sampleNames);
+  } else {
+    G.attr("dim") = Rcpp::Dimension( nsamples, variants.size() );
+    dimNames[0] = Rcpp::wrap(sampleNames);
+    dimNames[1] = arenaToR(variants.id);
+  }
   G.attr("dimnames") = dimNames;
 
+  if(info)
+    return Rcpp::List::create(Rcpp::Named("genotypes") = G, Rcpp::Named("snps") = variantsToR(variants));
   return G;
 }
+
+// packed = TRUE : l'objet packedGenotypes (cf packedGenotypes.cpp)
+static SEXP packedToR(Rcpp::XPtr<packedGenotypes> & P, const variantTable & variants,
+                      const std::vector<std::string> & sampleNames, bool info) {
+  P.attr("snps") = arenaToR(variants.id);
+  P.attr("samples") = Rcpp::wrap(sampleNames);
+  P.attr("class") = "packedGenotypes";
+  if(info)
+    return Rcpp::List::create(Rcpp::Named("genotypes") = P, Rcpp::Named("snps") = variantsToR(variants));
+  return P;
+}
+
+// lazy = TRUE : la matrice, décodée à la demande depuis P (dont le contenu
+// est déplacé), cf lazyGenotypes.cpp
+static SEXP lazyToR(packedGenotypes & P, bool byVariants) {
+  std::shared_ptr<const packedGenotypes> S = std::make_shared<packedGenotypes>(std::move(P));
+  return lazyGenotypesToR(new lazyGenotypes(S, byVariants));
+}
+
+// les génotypes de P dans la matrice g (variants x samples si byVariants,
+// sinon samples x variants)
+static void packedToMatrix(const packedGenotypes & P, int * g, bool byVariants) {
+  size_t nsnps = P.nSNPs(), nsamples = P.nSamples();
+  if(!byVariants) {
+    for(size_t i = 0; i < nsnps; i++) P.decodeSNP(i, g + i * nsamples, 1);
+    return;
+  }
+  P.decodeRows(0, nsnps, g, nsnps);
+}
+
+// variants = c(from, to) : les lignes de données from à to (à partir de 1)
+struct lineSpan {
+  size_t first;
+  size_t n;
+};
+
+static lineSpan variantRange(const std::vector<int> & v) {
+  if(v.size() != 2 || v[0] == NA_INTEGER || v[1] == NA_INTEGER || v[0] < 1 || v[1] < v[0])
+    Rcpp::stop("variants should be c(from, to), with 1 <= from <= to\n");
+  lineSpan r = {(size_t) v[0] - 1, (size_t) (v[1] - v[0]) + 1};
+  return r;
+}
+
+// cf readVCFgenotypes ; range = NULL : tout le fichier, prof = NULL sans profil
+static SEXP readGenotypes(std::string filename, int threads, Rcpp::Nullable<Rcpp::CharacterVector> region,
+                          bool presize, bool packed, bool mmap, SEXP samples, Rcpp::Nullable<Rcpp::List> filter,
+                          bool info, bool cache, std::string layout, bool lazy, const lineSpan * range,
+                          profileCounters * prof) {
+  if(layout != "variants" && layout != "samples")
+    Rcpp::stop("layout should be \"variants\" or \"samples\"\n");
+  bool byVariants = (layout == "variants");
+  std::vector<std::string> regions;
+  if(region.isNotNull())
+    regions = Rcpp::as< std::vector<std::string> >(region.get());
+  // cache = TRUE : un fichier lu en entier est mis en cache (filename.rvc, cf VCFcache.h),
+  // les lectures suivantes relisent le cache tant que le VCF n'a pas changé ;
+  // si des lignes ont seulement été ajoutées à la fin du VCF, seules celles-ci
+  // sont lues, et le cache est refait avec les anciens variants et les nouveaux
+  bool useCache = cache && regions.empty() && Rf_isNull(samples) && filter.isNull() && range == NULL;
+  uint64_t fileSize = 0;
+  int64_t fileTime = 0;
+  std::unique_ptr<VCFcache> old; // le cache d'un fichier qui a grandi
+  if(useCache) {
+    bool valid = false;
+    try {
+      std::string path = VCFcacheFile(filename);
+      uint64_t s;
+      int64_t t;
+      if(fileStamp(path, s, t)) {
+        old.reset(new VCFcache(path));
+        valid = old->matches(filename);
+        if(valid || !old->appended(filename)) old.reset();
+      }
+    } catch(std::exception & e) {
+      valid = false; // cache illisible : on le refait
+      old.reset();
+    }
+    if(valid)
+      return readVCFcache(filename, 1, -1, packed, info, layout, lazy);
+    fileStamp(filename, fileSize, fileTime);
+  }
+  // avec threads > 1, les lignes sont lues par morceaux et décodées en parallèle,
+  // sur le pool qui décompresse aussi les fichiers bgzip (cf VCFreader)
+  std::unique_ptr<threadPool> pool;
+  if(threads > 1) pool.reset(new threadPool(threads));
+  // mmap = TRUE : un fichier non compressé est projeté en mémoire et décodé sans copie
+  // cache = TRUE : la lecture s'arrête à la taille du fichier à cet instant ; les
+  // lignes ajoutées pendant la lecture seront lues la prochaine fois (cf makeVCFstamp)
+  VCFreader in(filename, threads, regions, mmap, pool.get(), useCache ? fileSize : UINT64_MAX);
+  if(range) in.lineRange(range->first, range->n);
+  if(old && old->fingerprint != headerFingerprint(in.header, in.samples))
+    old.reset(); // l'en-tête a changé : on relit tout
+  if(old) in.seekData(old->resume);
+  in.profile(prof);
+  // seules les colonnes des samples gardés sont décodées
+  sampleSelection keep = selectSamples(samples, in.samples);
+  std::vector<std::string> sampleNames = keep.names(in.samples);
+  size_t nsamples = sampleNames.size();
+  // les lignes rejetées par le filtre ne sont pas décodées
+  variantFilter F = makeFilter(filter);
+  bool filtered = F.active();
+
+  std::vector<genotypesSlot> slots(pool ? 2 * threads : 1, genotypesSlot(nsamples, info || useCache));
+  size_t chunkSize = (size_t) std::max(threads, 1) << 22;
+
+  // maintenant on lit le reste du fichier
+  // info = TRUE : on garde aussi CHROM, POS, REF, ALT
+  variantTable variants(info || useCache);
+  // profile = TRUE : le temps des merge, et la fin de la lecture
+  auto timedMerge = [prof](auto merge) {
+    return [prof, merge](int s) mutable {
+      if(prof == NULL) return merge(s);
+      uint64_t t0 = nowNs();
+      merge(s);
+      prof->mergeNs += nowNs() - t0;
+    };
+  };
+  auto parsed = [&]() {
+    if(prof == NULL) return;
+    for(genotypesSlot & S : slots) prof->add(S.prof);
+    prof->start(); // l'étape output
+  };
+  auto mergeIds = timedMerge([&](int s) {
+    variants.append(slots[s].variants);
+    slots[s].variants.clear();
+  });
+  auto noCheck = [](size_t) {};
+  // la place de la ligne row dans la matrice g (nsnps lignes) : dans la tuile
+  // du slot, ou directement à sa place si layout = "samples"
+  auto lineDest = [&](genotypesSlot & S, int * g, size_t nsnps, size_t row) {
+    return byVariants ? S.tile.next(row, g, nsnps) : g + row * nsamples;
+  };
+
+  Rcpp::IntegerVector G;
+  if(packed || lazy || useCache || !presize) {
+    // génotypes sur 2 bits, cf packedGenotypes.cpp pour les accesseurs ;
+    // sans presize, ils sont gardés ainsi jusqu'à la fin de la lecture, puis
+    // décodés dans la matrice (qui ne coexiste donc qu'avec 1/16 de sa taille)
+    Rcpp::XPtr<packedGenotypes> P(new packedGenotypes(nsamples), true);
+    if(old) {
+      old->load(variants, *P);
+      old.reset(); // libère la projection du cache avant de le refaire
+    } else if(presize && !filtered) {
+      size_t nsnps = in.countLines();
+      P->reserve(nsnps);
+      variants.reserve(nsnps);
+    }
+    parallelLines(in, pool.get(), chunkSize,
+      [&](int s, const char * b, const char * e, size_t) {
+        genotypesSlot & S = slots[s];
+        if(prof) countLine(S.prof, b, e);
+        if(filtered && !F.accept(b, e)) return;
+        VCFlineGenotypes(b, e, S.snp, S.packed, S.formats, keep, prof ? &S.prof : NULL);
+        if(!S.packed.endSNP())
+          throw std::runtime_error("VCF file format error (wrong number of genotypes)\n");
+        S.variants.push_back(S.snp);
+        if(prof) {
+          S.prof.samples += nsamples;
+          S.prof.na += S.packed.countNA(S.packed.nSNPs() - 1);
+        }
+      },
+      timedMerge([&](int s) {
+        P->append(slots[s].packed);
+        slots[s].packed.clear();
+        mergeIds(s);
+      }), noCheck);
+    parsed();
+    // le résultat est celui qui est en mémoire : le cache ne sert qu'aux
+    // lectures suivantes
+    if(useCache) {
+      try {
+        VCFstamp st = makeVCFstamp(filename, fileSize, fileTime, in.header, in.samples);
+        writeVCFcache(VCFcacheFile(filename), st, sampleNames, variants, *P);
+      } catch(std::exception & e) {
+        Rcpp::warning(e.what());
+      }
+    }
+    if(packed) {
+      return packedToR(P, variants, sampleNames, info);
+    }
+    if(lazy) {
+      return genotypesToR(lazyToR(*P, byVariants), variants, sampleNames, byVariants, info);
+    }
+    // la matrice à partir des génotypes lus (presize = FALSE, ou cache = TRUE)
+    G = Rcpp::IntegerVector( (R_xlen_t) (P->nSNPs() * nsamples) );
+    packedToMatrix(*P, G.begin(), byVariants);
+  } else if(filtered) {
+    // une première lecture évalue le filtre sur chaque ligne et donne
+    // la place des lignes gardées dans la matrice
+    std::vector<char> accepted;
+    std::vector< std::vector<char> > acc(slots.size());
+    VCFreader pre(filename, threads, regions, mmap, pool.get());
+    if(range) pre.lineRange(range->first, range->n);
+    pre.profile(prof);
+    parallelLines(pre, pool.get(), chunkSize,
+      [&](int s, const char * b, const char * e, size_t) { acc[s].push_back(F.accept(b, e)); },
+      timedMerge([&](int s) {
+        accepted.insert(accepted.end(), acc[s].begin(), acc[s].end());
+        acc[s].clear();
+      }), noCheck);
+    std::vector<size_t> row(accepted.size());
+    size_t nsnps = 0;
+    for(size_t i = 0; i < accepted.size(); i++) row[i] = accepted[i] ? nsnps++ : (size_t) -1;
+
+    G = Rcpp::IntegerVector( (R_xlen_t) (nsnps * nsamples) );
+    variants.reserve(nsnps);
+    int * g = G.begin();
+    size_t nlines = parallelLines(in, pool.get(), chunkSize,
+      [&](int s, const char * b, const char * e, size_t i) {
+        genotypesSlot & S = slots[s];
+        if(prof) countLine(S.prof, b, e);
+        if(row[i] == (size_t) -1) return;
+        int * d = lineDest(S, g, nsnps, row[i]);
+        VCFlineGenotypes(b, e, S.snp, d, 1, nsamples, S.formats, keep, prof ? &S.prof : NULL);
+        S.variants.push_back(S.snp);
+        if(prof) countGenotypes(S.prof, d, nsamples);
+      },
+      mergeIds,
+      [&](size_t n) {
+        if(n > row.size())
+          Rcpp::stop("More lines than expected in VCF file\n");
+      },
+      [&](int s) { slots[s].tile.flush(g, nsnps); });
+    if(nlines != row.size())
+      Rcpp::stop("Less lines than expected in VCF file\n");
+    parsed();
+  } else {
+    // on compte d'abord les lignes, et on écrit chaque génotype à sa place
+    size_t nsnps = in.countLines();
+    G = Rcpp::IntegerVector( (R_xlen_t) (nsnps * nsamples) );
+    variants.reserve(nsnps);
+    int * g = G.begin();
+    size_t nlines = parallelLines(in, pool.get(), chunkSize,
+      [&](int s, const char * b, const char * e, size_t i) {
+        genotypesSlot & S = slots[s];
+        int * d = lineDest(S, g, nsnps, i);
+        VCFlineGenotypes(b, e, S.snp, d, 1, nsamples, S.formats, keep, prof ? &S.prof : NULL);
+        S.variants.push_back(S.snp);
+        if(prof) {
+          countLine(S.prof, b, e);
+          countGenotypes(S.prof, d, nsamples);
+        }
+      },
+      mergeIds,
+      [&](size_t n) {
+        if(n > nsnps)
+          Rcpp::stop("More lines than expected in VCF file\n");
+      },
+      [&](int s) { slots[s].tile.flush(g, nsnps); });
+    if(nlines != nsnps)
+      Rcpp::stop("Less lines than expected in VCF file\n");
+    parsed();
+  }
+
+  return genotypesToR(G, variants, sampleNames, byVariants, info);
+}
+
+// readVCFgenotypes(c(fichiers)) : un fichier (par exemple un chromosome), dont
+// les variants vont dans les lignes first, first + 1, ... du résultat
+struct genotypesShard {
+  std::string filename;
+  uint64_t size; // l'ordre des tâches, cf forEachShard
+  std::vector<std::string> samples;
+  std::vector<char> accepted; // avec un filtre : les lignes gardées
+  size_t nlines; // lignes de données
+  size_t nsnps;  // lignes gardées
+  size_t first;
+  variantTable variants;
+  std::unique_ptr<packedGenotypes> packed;
+  profileCounters prof;
+  genotypesShard(const std::string & filename_, bool info)
+    : filename(filename_), size(0), nlines(0), nsnps(0), first(0), variants(info) {
+    int64_t t;
+    fileStamp(filename, size, t);
+  }
+};
+
+// les options communes aux fichiers
+struct shardOptions {
+  std::vector<std::string> regions; // les mêmes pour chaque fichier
+  bool mmap, packed, info, byVariants, profile;
+  // la décompression des fichiers bgzip : le pool quand les fichiers sont lus
+  // l'un après l'autre, sinon NULL (un thread par fichier)
+  threadPool * inflate;
+  sampleSelection keep;
+  size_t nsamples;
+  variantFilter F;
+};
+
+// première lecture : les samples de J, et son nombre de lignes (count = true ;
+// d'après l'index s'il y en a un, cf VCFreader::countLines) ;
+// avec un filtre, les lignes gardées. Pas d'API R (thread du pool)
+static void scanShard(genotypesShard & J, const shardOptions & O, bool count) {
+  VCFreader in(J.filename, 1, O.regions, O.mmap, O.inflate);
+  J.samples = in.samples;
+  if(!count) return;
+  if(O.F.active()) {
+    const char * b;
+    const char * e;
+    while(in.nextLine(b, e)) J.accepted.push_back(O.F.accept(b, e));
+    J.nlines = J.accepted.size();
+    J.nsnps = std::count(J.accepted.begin(), J.accepted.end(), 1);
+  } else {
+    J.nlines = J.nsnps = in.countLines();
+  }
+}
+
+// lit J : les génotypes vont dans les lignes J.first ... de la matrice g
+// (ld variants au total), ou dans J.packed (packed = TRUE)
+// Avec pool = NULL, tout est fait sur le thread appelant, qui est un thread du
+// pool quand les fichiers sont lus en parallèle : pas d'API R ici
+static void readShard(genotypesShard & J, const shardOptions & O, threadPool * pool,
+                      std::vector<genotypesSlot> & slots, int * g, size_t ld) {
+  VCFreader in(J.filename, 1, O.regions, O.mmap, O.inflate);
+  profileCounters * prof = O.profile ? &J.prof : NULL;
+  in.profile(prof);
+  size_t nsamples = O.nsamples;
+  bool filtered = O.F.active();
+  size_t chunkSize = (size_t) std::max(pool ? pool->size() : 1, 1) << 22;
+  auto mergeIds = [&](int s) {
+    J.variants.append(slots[s].variants);
+    slots[s].variants.clear();
+  };
+
+  if(O.packed) {
+    J.packed.reset(new packedGenotypes(nsamples));
+    parallelLines(in, pool, chunkSize,
+      [&](int s, const char * b, const char * e, size_t) {
+        genotypesSlot & S = slots[s];
+        if(prof) countLine(S.prof, b, e);
+        if(filtered && !O.F.accept(b, e)) return;
+        VCFlineGenotypes(b, e, S.snp, S.packed, S.formats, O.keep, prof ? &S.prof : NULL);
+        if(!S.packed.endSNP())
+          throw std::runtime_error("VCF file format error (wrong number of genotypes)\n");
+        S.variants.push_back(S.snp);
+        if(prof) {
+          S.prof.samples += nsamples;
+          S.prof.na += S.packed.countNA(S.packed.nSNPs() - 1);
+        }
+      },
+      [&](int s) {
+        J.packed->append(slots[s].packed);
+        slots[s].packed.clear();
+        mergeIds(s);
+      }, [](size_t) {});
+  } else {
+    // la ligne i du fichier va dans la ligne first + row[i] de g
+    std::vector<size_t> row;
+    if(filtered) {
+      row.resize(J.nlines);
+      size_t k = 0;
+      for(size_t i = 0; i < J.nlines; i++) row[i] = J.accepted[i] ? k++ : (size_t) -1;
+      std::vector<char>().swap(J.accepted);
+    }
+    size_t nlines = parallelLines(in, pool, chunkSize,
+      [&](int s, const char * b, const char * e, size_t i) {
+        genotypesSlot & S = slots[s];
+        if(prof) countLine(S.prof, b, e);
+        if(filtered && row[i] == (size_t) -1) return;
+        size_t r = J.first + (filtered ? row[i] : i);
+        int * d = O.byVariants ? S.tile.next(r, g, ld) : g + r * nsamples;
+        VCFlineGenotypes(b, e, S.snp, d, 1, nsamples, S.formats, O.keep, prof ? &S.prof : NULL);
+        S.variants.push_back(S.snp);
+        if(prof) countGenotypes(S.prof, d, nsamples);
+      },
+      mergeIds,
+      [&](size_t n) {
+        if(n > J.nlines)
+          throw std::runtime_error("More lines than expected in VCF file\n");
+      },
+      [&](int s) { slots[s].tile.flush(g, ld); });
+    if(nlines != J.nlines)
+      throw std::runtime_error("Less lines than expected in VCF file\n");
+  }
+  for(genotypesSlot & S : slots) {
+    J.prof.add(S.prof);
+    S.prof = profileCounters();
+  }
+}
+
+// f(J) pour chaque fichier : en parallèle, une tâche par fichier (les plus
+// gros d'abord : un thread libre prend le fichier suivant, les derniers sont
+// les plus courts), ou sur le thread principal sans pool
+// Les erreurs sont relancées ici, avec le nom du fichier
+template<typename F>
+void forEachShard(std::vector<genotypesShard> & shards, threadPool * pool, F f) {
+  std::vector<size_t> order(shards.size());
+  for(size_t k = 0; k < order.size(); k++) order[k] = k;
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return shards[a].size > shards[b].size; });
+  std::vector<std::string> errors(shards.size());
+  auto run = [&](size_t k) {
+    try {
+      f(shards[k]);
+    } catch(std::exception & e) {
+      errors[k] = shards[k].filename + ": " + e.what();
+    }
+  };
+  if(pool == NULL) {
+    for(size_t k : order) run(k);
+  } else {
+    std::vector< std::future<void> > jobs;
+    for(size_t k : order) jobs.push_back(pool->push([&run, k] { run(k); }));
+    waitJobs(jobs);
+  }
+  for(const std::string & e : errors)
+    if(!e.empty()) Rcpp::stop(e);
+}
+
+// readVCFgenotypes avec plusieurs fichiers (mêmes samples, dans le même ordre) :
+// les variants sont mis bout à bout, dans l'ordre des fichiers, dans un seul
+// résultat, alloué d'après le nombre de lignes de chaque fichier (une première
+// lecture, cf scanShard ; packed = TRUE s'en passe). Un seul pool de threads :
+// quand il y a au moins autant de fichiers que de threads, les fichiers sont lus
+// en parallèle, chacun par un thread, sinon l'un après l'autre, les lignes de
+// chacun étant réparties sur le pool, qui les décompresse aussi
+static SEXP readGenotypesFiles(const std::vector<std::string> & filenames, int threads,
+                               Rcpp::Nullable<Rcpp::CharacterVector> region, bool packed, bool mmap,
+                               SEXP samples, Rcpp::Nullable<Rcpp::List> filter, bool info, bool cache,
+                               std::string layout, bool lazy, profileCounters * prof) {
+  if(layout != "variants" && layout != "samples")
+    Rcpp::stop("layout should be \"variants\" or \"samples\"\n");
+  if(cache)
+    Rcpp::stop("cache = TRUE needs a single file\n");
+  shardOptions O;
+  if(region.isNotNull())
+    O.regions = Rcpp::as< std::vector<std::string> >(region.get());
+  O.mmap = mmap;
+  O.packed = packed || lazy; // lazy : les génotypes sur 2 bits, cf lazyToR
+  O.info = info;
+  O.byVariants = (layout == "variants");
+  O.profile = (prof != NULL);
+  O.F = makeFilter(filter);
+
+  std::unique_ptr<threadPool> pool;
+  if(threads > 1) pool.reset(new threadPool(threads));
+  bool byFile = !pool || (int) filenames.size() >= threads;
+  O.inflate = byFile ? NULL : pool.get();
+  std::vector<genotypesShard> shards;
+  shards.reserve(filenames.size());
+  for(const std::string & f : filenames) shards.emplace_back(f, info);
+
+  // l'un après l'autre sur le thread principal quand le pool décompresse
+  forEachShard(shards, byFile ? pool.get() : NULL, [&](genotypesShard & J) { scanShard(J, O, !O.packed); });
+  for(const genotypesShard & J : shards) {
+    if(J.samples != shards[0].samples)
+      Rcpp::stop("The samples of " + J.filename + " are not those of " + shards[0].filename + "\n");
+  }
+  O.keep = selectSamples(samples, shards[0].samples);
+  std::vector<std::string> sampleNames = O.keep.names(shards[0].samples);
+  O.nsamples = sampleNames.size();
+
+  size_t nsnps = 0;
+  for(genotypesShard & J : shards) {
+    J.first = nsnps;
+    nsnps += J.nsnps;
+  }
+  Rcpp::IntegerVector G;
+  if(!O.packed) G = Rcpp::IntegerVector( (R_xlen_t) (nsnps * O.nsamples) );
+  int * g = O.packed ? NULL : G.begin();
+
+  if(byFile) {
+    forEachShard(shards, pool.get(), [&](genotypesShard & J) {
+      std::vector<genotypesSlot> slots(1, genotypesSlot(O.nsamples, info));
+      readShard(J, O, NULL, slots, g, nsnps);
+    });
+  } else {
+    std::vector<genotypesSlot> slots(2 * threads, genotypesSlot(O.nsamples, info));
+    for(genotypesShard & J : shards) {
+      try {
+        readShard(J, O, pool.get(), slots, g, nsnps);
+      } catch(std::exception & e) {
+        Rcpp::stop(J.filename + ": " + e.what());
+      }
+    }
+  }
+
+  // les variants (et les génotypes packed) dans l'ordre des fichiers
+  variantTable variants(info);
+  variants.reserve(nsnps);
+  for(genotypesShard & J : shards) {
+    variants.append(J.variants);
+    J.variants.clear();
+    if(prof) prof->add(J.prof);
+  }
+  if(prof) prof->start(); // l'étape output
+  if(O.packed) {
+    Rcpp::XPtr<packedGenotypes> P(new packedGenotypes(O.nsamples), true);
+    size_t n = 0;
+    for(genotypesShard & J : shards) n += J.packed->nSNPs();
+    P->reserve(n);
+    for(genotypesShard & J : shards) {
+      P->append(*J.packed);
+      J.packed.reset();
+    }
+    if(lazy)
+      return genotypesToR(lazyToR(*P, O.byVariants), variants, sampleNames, O.byVariants, info);
+    return packedToR(P, variants, sampleNames, info);
+  }
+  return genotypesToR(G, variants, sampleNames, O.byVariants, info);
+}
+
+// presize = TRUE : les lignes sont d'abord comptées (d'après un index quand il
+//   y en a un) et chaque génotype est écrit directement à sa place dans la
+//   matrice ; sinon le fichier n'est lu qu'une fois, les génotypes sont gardés
+//   sur 2 bits puis décodés dans la matrice à la fin (1/16 de mémoire en plus)
+// region : des régions "chr:beg-end", dans un fichier bgzip avec un index tabix,
+//   ou dans un fichier non compressé avec l'index de buildVCFindex
+// variants = c(from, to) : seulement les variants from à to (numéros des lignes
+//   de données, à partir de 1) ; avec l'index de buildVCFindex, la lecture d'un
+//   fichier non compressé commence au bloc de from, sans lire ce qui précède
+// filename : un fichier, ou plusieurs (par exemple un par chromosome) qui ont
+//   les mêmes samples : leurs variants sont mis bout à bout dans un seul
+//   résultat, cf readGenotypesFiles (presize est alors toujours vrai)
+// layout = "variants" : une matrice variants x samples (les génotypes d'un
+//   sample sont contigus) ; les lignes sont transposées par tuiles (cf lineTile.h)
+// layout = "samples" : une matrice samples x variants (les génotypes d'un
+//   variant sont contigus, dans l'ordre du fichier, sans transposition)
+// profile = TRUE : le résultat a un attribut "profile", un vecteur nommé avec
+//   les octets et les lignes lus, le nombre de génotypes décodés et de NA, et
+//   le temps de chaque étape en nanosecondes (cf profile.h ; les étapes des
+//   threads du pool sont additionnées), le temps total (wall.ns) et threads
+// lazy = TRUE : la matrice reste sur 2 bits (dans le cache projeté en mémoire
+//   avec cache = TRUE, sinon en mémoire) et n'est décodée qu'à la demande : les
+//   éléments et les morceaux lus sont décodés au vol, sum() ne décode rien, et
+//   tout le reste décode la matrice entière une fois (cf lazyGenotypes.cpp)
+// [[Rcpp::export]]
+SEXP readVCFgenotypes(std::vector<std::string> filename, int threads = 1, Rcpp::Nullable<Rcpp::CharacterVector> region = R_NilValue,
+                      bool presize = false, bool packed = false, bool mmap = true, SEXP samples = R_NilValue,
+                      Rcpp::Nullable<Rcpp::List> filter = R_NilValue, bool info = false, bool cache = false,
+                      std::string layout = "variants", bool profile = false,
+                      Rcpp::Nullable<Rcpp::IntegerVector> variants = R_NilValue, bool lazy = false) {
+  if(filename.empty())
+    Rcpp::stop("No file to read\n");
+  if(packed && lazy)
+    Rcpp::stop("packed and lazy can't be both TRUE\n");
+  lineSpan range;
+  if(variants.isNotNull()) {
+    if(filename.size() > 1)
+      Rcpp::stop("variants = needs a single file\n");
+    range = variantRange(Rcpp::as< std::vector<int> >(variants.get()));
+  }
+  const lineSpan * r = variants.isNotNull() ? &range : NULL;
+  auto read = [&](profileCounters * prof) {
+    if(filename.size() > 1)
+      return readGenotypesFiles(filename, threads, region, packed, mmap, samples, filter, info, cache, layout, lazy, prof);
+    return readGenotypes(filename[0], threads, region, presize, packed, mmap, samples, filter, info, cache, layout, lazy, r, prof);
+  };
+  if(!profile)
+    return read(NULL);
+  profileCounters P;
+  P.start();
+  uint64_t t0 = P.t;
+  Rcpp::RObject res(read(&P));
+  P.lap(P.outputNs);
+  res.attr("profile") = Rcpp::NumericVector::create(Rcpp::Named("bytes") = (double) P.bytes,
+    Rcpp::Named("lines") = (double) P.lines, Rcpp::Named("samples") = (double) P.samples,
+    Rcpp::Named("NA") = (double) P.na, Rcpp::Named("read.ns") = (double) P.readNs,
+    Rcpp::Named("fields.ns") = (double) P.fieldsNs, Rcpp::Named("genotypes.ns") = (double) P.genotypesNs,
+    Rcpp::Named("merge.ns") = (double) P.mergeNs, Rcpp::Named("output.ns") = (double) P.outputNs,
+    Rcpp::Named("wall.ns") = (double) (P.t - t0), Rcpp::Named("threads") = (double) threads);
+  return res;
+}
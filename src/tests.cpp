@@ -6,6 +6,8 @@
 #include "tokenPosition.h"
 #include "tokenAtPosition.h"
 #include "VCFlineGenotypes.h"
+#include "VCFreader.h"
+#include "tabix.h"
 
 // [[Rcpp::export]]
 int test1(std::string s) {
@@ -33,3 +35,52 @@ Rcpp::IntegerVector test4() {
   return Rcpp::wrap(genos);
 }
 
+
+// nombre de lignes de données d'un fichier bgzip : d'après son index tabix,
+// puis en lisant tout le fichier
+// [[Rcpp::export]]
+Rcpp::NumericVector test5(std::string filename) {
+  tabixIndex idx(filename);
+  VCFreader in(filename);
+  size_t n = 0;
+  std::string line;
+  while(in.getline(line)) n++;
+  Rcpp::NumericVector res(2);
+  res[0] = idx.nLines();
+  res[1] = n;
+  return res;
+}
+
+// nombre de lignes d'une région : en passant par l'index, puis en lisant
+// tout le fichier
+// [[Rcpp::export]]
+Rcpp::NumericVector test6(std::string filename, std::string region) {
+  VCFreader rin(filename, 1, std::vector<std::string>(1, region));
+  size_t n1 = 0, n2 = 0;
+  std::string line;
+  while(rin.getline(line)) n1++;
+  genomicRegion r = parseRegion(region);
+  VCFreader in(filename);
+  bool after;
+  while(in.getline(line)) n2 += lineInRegion(line, r, after);
+  Rcpp::NumericVector res(2);
+  res[0] = n1;
+  res[1] = n2;
+  return res;
+}
+
+// comme VCFdims : l'index est-il utilisé, le nombre de lignes d'après
+// countLines, puis en lisant tout le fichier
+// [[Rcpp::export]]
+Rcpp::NumericVector test7(std::string filename) {
+  VCFreader din(filename, 1, std::vector<std::string>(), true);
+  VCFreader in(filename);
+  size_t n = 0;
+  std::string line;
+  while(in.getline(line)) n++;
+  Rcpp::NumericVector res(3);
+  res[0] = din.indexed();
+  res[1] = din.countLines();
+  res[2] = n;
+  return res;
+}